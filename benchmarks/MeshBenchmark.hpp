@@ -0,0 +1,94 @@
+#pragma once
+
+/// Defines
+# define MESH_REGION_MIN	glm::ivec3(-1, -3, -1) // Generated chunks, in chunks
+# define MESH_REGION_MAX	glm::ivec3(6, 2, 6) // The meshed ones are inside, with their 6 neighbours generated
+
+/// System includes
+# include <unordered_map>
+# include <vector>
+
+/// Dependencies
+# include "benchmark.hpp"
+# include "VoxelSystem.hpp"
+# include "ChunkHandler.hpp"
+
+// Generated region shared by the meshing benchmarks.
+// The chunks are snapshotted and meshed through the VoxelSystem methods the mesh jobs use.
+class	MeshBenchmark {
+	private:
+		std::unordered_map<glm::ivec3, ChunkData>	_chunks;
+		std::vector<glm::ivec3>				_meshedChunks; // Layered chunks inside the region
+		double						_generationTime; // in ms
+
+	public:
+		MeshBenchmark() {
+			BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+			for (int x = MESH_REGION_MIN.x; x <= MESH_REGION_MAX.x; x++) {
+				for (int y = MESH_REGION_MIN.y; y <= MESH_REGION_MAX.y; y++) {
+					for (int z = MESH_REGION_MIN.z; z <= MESH_REGION_MAX.z; z++) {
+						ChunkData &	data = _chunks[{x, y, z}];
+
+						data.Wpos = {x, y, z};
+						data.LOD = 1;
+						data.chunk = ChunkHandler::createChunk({x, y, z});
+					}
+				}
+			}
+			_generationTime = elapsedNs(start) / 1e6;
+
+			for (int x = MESH_REGION_MIN.x + 1; x < MESH_REGION_MAX.x; x++) {
+				for (int y = MESH_REGION_MIN.y + 1; y < MESH_REGION_MAX.y; y++) {
+					for (int z = MESH_REGION_MIN.z + 1; z < MESH_REGION_MAX.z; z++) {
+						const AChunk *	chunk = _chunks.at({x, y, z}).chunk;
+
+						if (!IS_CHUNK_COMPRESSED(chunk))
+							_meshedChunks.push_back({x, y, z});
+					}
+				}
+			}
+		}
+
+		~MeshBenchmark() {
+			for (auto &chunk : _chunks)
+				ChunkHandler::releaseChunk(chunk.second.chunk);
+		}
+
+		/// Getters
+
+		const std::vector<glm::ivec3> &	getMeshedChunks() const { return (_meshedChunks); }
+		size_t				getChunkCount() const { return (_chunks.size()); }
+		double				getGenerationTime() const { return (_generationTime); }
+
+		// Every block of the region, to compare the generation of two builds
+		uint64_t	hashBlocks() const {
+			uint64_t	hash = BENCHMARK_HASH_INIT;
+
+			for (int x = MESH_REGION_MIN.x; x <= MESH_REGION_MAX.x; x++)
+				for (int y = MESH_REGION_MIN.y; y <= MESH_REGION_MAX.y; y++)
+					for (int z = MESH_REGION_MIN.z; z <= MESH_REGION_MAX.z; z++)
+						for (int i = 0; i < CHUNK_WIDTH; i++)
+							for (int j = 0; j < CHUNK_HEIGHT; j++)
+								for (int k = 0; k < CHUNK_WIDTH; k++)
+									hashValue(hash, BLOCK_AT(_chunks.at({x, y, z}).chunk, i, j, k));
+			return (hash);
+		}
+
+		/// Meshing
+
+		// Same snapshot as a mesh job, pos must be one of the meshed chunks
+		void	takeSnapshot(MeshSnapshot &snapshot, const glm::ivec3 &pos) {
+			const glm::ivec3	offsets[6] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+			ChunkData *		neightbours[6];
+
+			for (int i = 0; i < 6; i++)
+				neightbours[i] = &_chunks.at(pos + offsets[i]);
+			VoxelSystem::_takeMeshSnapshot(snapshot, _chunks.at(pos), neightbours);
+		}
+
+		static void	constructMesh(std::vector<DATA_TYPE> &vertices, const MeshSnapshot &snapshot) {
+			vertices.clear();
+			VoxelSystem::_constructChunkMesh(&vertices, snapshot, snapshot.LOD);
+		}
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+/// Defines
+# define BENCHMARK_SEED	42 // When no seed is given, timings and hashes are only comparable on the same seed
+# define BENCHMARK_HASH_INIT	1469598103934665603ull // FNV-1a offset basis
+
+/// System includes
+# include <iostream>
+# include <iomanip>
+# include <chrono>
+# include <thread>
+# include <algorithm>
+# include <cstdint>
+# include <cstdlib>
+
+/// Dependencies
+# include "Noise.hpp"
+
+using namespace std;
+
+// Shared helpers of the benchmarks, each benchmark is a separate executable:
+//   ./bench_xxx [flags] [seed]
+// The flags are the ones of ft_vox, so -P, -I, -n, ... change the generated chunks the same way.
+// A benchmark prints its timings and exits with EXIT_FAILURE when its results are wrong.
+
+/// Functions
+
+// flags.cpp
+uint64_t	flagHandler(int argc, char **argv);
+
+typedef chrono::steady_clock	BenchmarkClock;
+
+// Parse the ft_vox flags and seed the noise, the seed is BENCHMARK_SEED unless one is given
+static inline uint64_t	initBenchmark(int argc, char **argv) {
+	uint64_t	seed = flagHandler(argc, argv);
+
+	if (!seed)
+		seed = BENCHMARK_SEED;
+	Noise::setSeed(seed);
+	return (seed);
+}
+
+static inline double	elapsedNs(const BenchmarkClock::time_point &start) {
+	return (chrono::duration<double, nano>(BenchmarkClock::now() - start).count());
+}
+
+// Keep the compiler from dropping a result that is never read
+static inline void	keepResult(const void *result) {
+	__asm__ volatile("" : : "r"(result) : "memory");
+}
+
+// FNV-1a, outputs hashed the same way can be compared between two builds
+static inline void	hashValue(uint64_t &hash, const uint64_t &value) {
+	hash ^= value;
+	hash *= 1099511628211ull;
+}
+
+// 1, 2, 4, ... threads, up to the core count and at least 4 to still show contention on small machines
+static inline unsigned int	benchmarkMaxThreads() {
+	return (max(4u, thread::hardware_concurrency()));
+}
@@ -0,0 +1,212 @@
+# include "MeshBenchmark.hpp"
+
+# include <cstring>
+# include <memory>
+
+# include "BitMatrix.hpp"
+# include "CPUDispatch.hpp"
+
+/// Defines
+# define MASK_SIZE	((CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)) // Same as the bitmasks of _constructChunkMesh
+# define MASK_ROUNDS	200
+# define TRANSPOSE_ROUNDS	1000000
+# define TRANSPOSE_MATRICES	4096 // Random matrices each kernel is checked on
+
+// Mask stage benchmark, the three axis bitmasks _constructChunkMesh builds at LOD 1, over the chunks of MeshBenchmark:
+// - The voxel scan of the mesher before the transpose
+// - A copy of the three orientations, as when every chunk stored them
+// - The transpose of the occupancy columns, with each transpose32 kernel
+// The masks of every variant must match the voxel scan bit for bit.
+// Each transpose32 kernel must also match the bit by bit transpose on random matrices, and is timed alone.
+class	BitMatrixBenchmark {
+	private:
+		typedef struct Masks {
+			uint64_t	axis[3][MASK_SIZE]; // x, y and z bitmasks
+		} Masks;
+
+		typedef struct StoredMasks {
+			uint32_t	axis[3][OCCUPANCY_SIZE];
+		} StoredMasks;
+
+		typedef struct Kernel {
+			const char *			name;
+			BitMatrix::Transpose32Func	func;
+		} Kernel;
+
+		std::vector<std::unique_ptr<MeshSnapshot>>	_snapshots;
+		std::vector<std::unique_ptr<StoredMasks>>	_storedMasks; // The three orientations of each snapshot
+		std::unique_ptr<Masks>				_masks, _reference;
+
+		// The mesher before the transpose, a bit per solid block on each axis
+		static void	_voxelScan(const MeshSnapshot &snapshot, Masks &masks) {
+			memset(&masks, 0, sizeof(Masks));
+			for (uint64_t y = 0; y < CHUNK_HEIGHT; y++) {
+				for (uint64_t z = 0; z < CHUNK_WIDTH; z++) {
+					for (uint64_t x = 0; x < CHUNK_WIDTH; x++) {
+						if (snapshot.blocks[y][x * CHUNK_WIDTH + z] != 0) {
+							masks.axis[0][y * CHUNK_HEIGHT + z] |= 1ull << (x + 1);
+							masks.axis[1][z * CHUNK_WIDTH + x] |= 1ull << (y + 1);
+							masks.axis[2][y * CHUNK_HEIGHT + x] |= 1ull << (z + 1);
+						}
+					}
+				}
+			}
+		}
+
+		static void	_copyStored(const StoredMasks &stored, Masks &masks) {
+			for (uint64_t i = 0; i < OCCUPANCY_SIZE; i++)
+				for (int axis = 0; axis < 3; axis++)
+					masks.axis[axis][i] = (uint64_t)stored.axis[axis][i] << 1;
+		}
+
+		// Same derivation as _constructChunkMesh, with the given kernel
+		static void	_transposeMasks(const MeshSnapshot &snapshot, Masks &masks, const BitMatrix::Transpose32Func &transpose) {
+			uint32_t	columns[CHUNK_WIDTH];
+
+			for (uint64_t i = 0; i < CHUNK_WIDTH * CHUNK_HEIGHT; i++)
+				masks.axis[2][i] = (uint64_t)snapshot.occupancy[i] << 1;
+
+			for (uint64_t y = 0; y < CHUNK_HEIGHT; y++) {
+				memcpy(columns, snapshot.occupancy + y * CHUNK_WIDTH, sizeof(columns));
+				transpose(columns);
+				for (uint64_t z = 0; z < CHUNK_WIDTH; z++)
+					masks.axis[0][y * CHUNK_HEIGHT + z] = (uint64_t)columns[z] << 1;
+			}
+
+			for (uint64_t x = 0; x < CHUNK_WIDTH; x++) {
+				for (uint64_t y = 0; y < CHUNK_HEIGHT; y++)
+					columns[y] = snapshot.occupancy[y * CHUNK_WIDTH + x];
+				transpose(columns);
+				for (uint64_t z = 0; z < CHUNK_WIDTH; z++)
+					masks.axis[1][z * CHUNK_WIDTH + x] = (uint64_t)columns[z] << 1;
+			}
+		}
+
+		// Bit j of rows[i] becomes bit i of rows[j], one bit at a time
+		static void	_transposeBits(const uint32_t *rows, uint32_t *out) {
+			memset(out, 0, sizeof(uint32_t) * 32);
+			for (int i = 0; i < 32; i++)
+				for (int j = 0; j < 32; j++)
+					out[j] |= ((rows[i] >> j) & 1u) << i;
+		}
+
+		static std::vector<Kernel>	_kernels() {
+			std::vector<Kernel>	kernels = {{"scalar", &BitMatrix::_transpose32Scalar}};
+
+# ifdef CPU_DISPATCH_X86
+			if (CPUDispatch::getLevel() >= CPULevel::SSE2)
+				kernels.push_back({"SSE2", &BitMatrix::_transpose32SSE2});
+			if (CPUDispatch::getLevel() >= CPULevel::AVX2)
+				kernels.push_back({"AVX2", &BitMatrix::_transpose32AVX2});
+# endif
+			return (kernels);
+		}
+
+		// us per chunk to build the masks, then the number of chunks whose masks differ from the voxel scan
+		template <typename Func>
+		bool	_variant(const std::string &name, const Func &func) {
+			BenchmarkClock::time_point	start = BenchmarkClock::now();
+			size_t				mismatches = 0;
+
+			for (int r = 0; r < MASK_ROUNDS; r++) {
+				for (size_t i = 0; i < _snapshots.size(); i++) {
+					func(i, *_masks);
+					keepResult(_masks.get());
+				}
+			}
+
+			const double	us = elapsedNs(start) / MASK_ROUNDS / _snapshots.size() / 1000;
+
+			for (size_t i = 0; i < _snapshots.size(); i++) {
+				_voxelScan(*_snapshots[i], *_reference);
+				func(i, *_masks);
+				mismatches += memcmp(_masks.get(), _reference.get(), sizeof(Masks)) != 0;
+			}
+			cout << "  " << left << setw(24) << name << right << fixed << setprecision(2) << setw(8) << us << " us per chunk | "
+				<< (mismatches ? "MISMATCH on " + to_string(mismatches) + " chunks" : "matches the voxel scan") << endl;
+			return (!mismatches);
+		}
+
+	public:
+		BitMatrixBenchmark(MeshBenchmark &region) : _masks(new Masks), _reference(new Masks) {
+			for (const glm::ivec3 &pos : region.getMeshedChunks()) {
+				_snapshots.emplace_back(new MeshSnapshot);
+				region.takeSnapshot(*_snapshots.back(), pos);
+
+				_voxelScan(*_snapshots.back(), *_reference);
+				_storedMasks.emplace_back(new StoredMasks);
+				for (uint64_t i = 0; i < OCCUPANCY_SIZE; i++)
+					for (int axis = 0; axis < 3; axis++)
+						_storedMasks.back()->axis[axis][i] = _reference->axis[axis][i] >> 1;
+			}
+		}
+
+		bool	maskStage() {
+			bool	success = true;
+
+			cout << "Mask stage, " << _snapshots.size() << " chunks" << endl;
+			success &= _variant("voxel scan", [&](size_t i, Masks &masks) { _voxelScan(*_snapshots[i], masks); });
+			success &= _variant("3 stored masks", [&](size_t i, Masks &masks) { _copyStored(*_storedMasks[i], masks); });
+			for (const Kernel &kernel : _kernels()) {
+				success &= _variant(std::string("transpose ") + kernel.name, [&](size_t i, Masks &masks) {
+					_transposeMasks(*_snapshots[i], masks, kernel.func);
+				});
+			}
+			return (success);
+		}
+
+		static bool	transposeKernels() {
+			std::vector<uint32_t>	matrices(TRANSPOSE_MATRICES * 32);
+			uint64_t		state = BENCHMARK_HASH_INIT;
+			uint32_t		rows[32], expected[32];
+			bool			success = true;
+
+			for (uint32_t &row : matrices) {
+				hashValue(state, row);
+				row = state >> 32;
+			}
+			// Sparse and full rows too, like the occupancy of the surface
+			for (int i = 0; i < 32; i++) {
+				matrices[i] = 1u << i;
+				matrices[32 + i] = ~0u;
+			}
+
+			cout << "transpose32 kernels, " << TRANSPOSE_MATRICES << " random matrices" << endl;
+			for (const Kernel &kernel : _kernels()) {
+				size_t	mismatches = 0;
+
+				for (size_t m = 0; m < TRANSPOSE_MATRICES; m++) {
+					memcpy(rows, &matrices[m * 32], sizeof(rows));
+					kernel.func(rows);
+					_transposeBits(&matrices[m * 32], expected);
+					mismatches += memcmp(rows, expected, sizeof(rows)) != 0;
+				}
+
+				BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+				memcpy(rows, matrices.data(), sizeof(rows));
+				for (int r = 0; r < TRANSPOSE_ROUNDS; r++) {
+					kernel.func(rows);
+					keepResult(rows);
+				}
+				cout << "  " << left << setw(24) << kernel.name << right << fixed << setprecision(1) << setw(8)
+					<< elapsedNs(start) / TRANSPOSE_ROUNDS << " ns per matrix | "
+					<< (mismatches ? "MISMATCH on " + to_string(mismatches) + " matrices" : "matches the bit by bit transpose") << endl;
+				success &= !mismatches;
+			}
+			return (success);
+		}
+};
+
+int	main(int argc, char **argv) {
+	uint64_t		seed = initBenchmark(argc, argv);
+	MeshBenchmark		region;
+	BitMatrixBenchmark	benchmark(region);
+	bool			success = true;
+
+	cout << "Seed " << seed << endl;
+	success &= benchmark.maskStage();
+	success &= BitMatrixBenchmark::transposeKernels();
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
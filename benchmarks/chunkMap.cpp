@@ -0,0 +1,366 @@
+# include "benchmark.hpp"
+
+# include <atomic>
+# include <functional>
+# include <mutex>
+# include <string>
+# include <unordered_map>
+# include <vector>
+
+# include "VoxelSystem.hpp"
+
+/// Defines
+# define MAP_FINDS_PER_THREAD	200000
+# define MAP_NEIGHBOURHOODS_PER_THREAD	50000
+# define MAP_MIXED_PER_THREAD	200000 // 80% find, 10% insert, 10% erase
+# define MAP_ROUNDS	3
+
+// Chunk maps benchmark, with the render box of chunks loaded and 1 to N threads, in M operations per second:
+// - insert, the threads fill the box together
+// - find and findNeightbourhood on random positions of the box
+// - mixed, 80% find, 10% insert and 10% erase
+// The maps are compared with the unordered_map guarded by a single mutex that VoxelSystem used before them,
+// and with the shards of unordered_map HashChunkMap was made of before its flat tables.
+// Every position inserted must be found, and every neighbourhood must hold the neighbours inside the box.
+class	ChunkMapBenchmark {
+	private:
+		// The _chunksMutex and unordered_map of VoxelSystem before the chunk maps
+		class	MutexChunkMap : public AChunkMap {
+			private:
+				std::unordered_map<glm::ivec3, ChunkData>	_chunks;
+				std::mutex					_mutex;
+
+			protected:
+				bool	_find(const glm::ivec3 &pos, const FindCallback &fn) override {
+					std::lock_guard<std::mutex>	lock(_mutex);
+					auto				it = _chunks.find(pos);
+
+					if (it == _chunks.end())
+						return (false);
+					fn(it->second);
+					return (true);
+				}
+
+				void	_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn) override {
+					std::lock_guard<std::mutex>	lock(_mutex);
+					auto				inserted = _chunks.try_emplace(pos);
+
+					if (!fn(inserted.first->second, inserted.second) && inserted.second)
+						_chunks.erase(inserted.first);
+				}
+
+				void	_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn) override {
+					std::lock_guard<std::mutex>	lock(_mutex);
+					const glm::ivec3		offsets[6] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+					ChunkData *			neightbours[6];
+					auto				it = _chunks.find(pos);
+
+					for (int i = 0; i < 6; i++) {
+						auto	neightbour = _chunks.find(pos + offsets[i]);
+
+						neightbours[i] = (neightbour != _chunks.end()) ? &neightbour->second : nullptr;
+					}
+					fn((it != _chunks.end()) ? &it->second : nullptr, neightbours);
+				}
+
+				bool	_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred) override {
+					std::lock_guard<std::mutex>	lock(_mutex);
+					auto				it = _chunks.find(pos);
+
+					if (it == _chunks.end() || !pred(it->second))
+						return (false);
+					_chunks.erase(it);
+					return (true);
+				}
+
+				void	_forEach(const FindCallback &fn) override {
+					std::lock_guard<std::mutex>	lock(_mutex);
+
+					for (auto &chunk : _chunks)
+						fn(chunk.second);
+				}
+
+			public:
+				void	clear() override {
+					std::lock_guard<std::mutex>	lock(_mutex);
+
+					_chunks.clear();
+				}
+
+				size_t	size() const override { return (_chunks.size()); }
+		};
+
+		// The shards of std::unordered_map HashChunkMap used before its flat open-addressing tables
+		class	ShardedChunkMap : public AChunkMap {
+			private:
+				typedef struct alignas(64) Shard {
+					std::mutex					mutex;
+					std::unordered_map<glm::ivec3, ChunkData>	chunks;
+				} Shard;
+
+				static const size_t	_shardCount = (size_t)1 << HASH_CHUNK_MAP_SHARD_BITS;
+
+				Shard			_shards[_shardCount];
+				std::atomic<size_t>	_size;
+
+				static size_t	_shardIndex(const glm::ivec3 &pos) {
+					return ((std::hash<glm::ivec3>{}(pos) * 0x9E3779B97F4A7C15ull) >> (64 - HASH_CHUNK_MAP_SHARD_BITS));
+				}
+
+			protected:
+				bool	_find(const glm::ivec3 &pos, const FindCallback &fn) override {
+					Shard &				shard = _shards[_shardIndex(pos)];
+					std::lock_guard<std::mutex>	lock(shard.mutex);
+					auto				it = shard.chunks.find(pos);
+
+					if (it == shard.chunks.end())
+						return (false);
+					fn(it->second);
+					return (true);
+				}
+
+				void	_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn) override {
+					Shard &				shard = _shards[_shardIndex(pos)];
+					std::lock_guard<std::mutex>	lock(shard.mutex);
+					auto				inserted = shard.chunks.try_emplace(pos);
+
+					if (!fn(inserted.first->second, inserted.second) && inserted.second) {
+						shard.chunks.erase(inserted.first);
+						return ;
+					}
+					if (inserted.second)
+						_size++;
+				}
+
+				void	_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn) override {
+					const glm::ivec3	positions[7] = {
+						pos,
+						{pos.x - 1, pos.y, pos.z}, {pos.x + 1, pos.y, pos.z},
+						{pos.x, pos.y - 1, pos.z}, {pos.x, pos.y + 1, pos.z},
+						{pos.x, pos.y, pos.z - 1}, {pos.x, pos.y, pos.z + 1}
+					};
+					size_t		indices[7];
+					size_t		sorted[7];
+					ChunkData *	chunks[7];
+
+					for (size_t i = 0; i < 7; i++)
+						indices[i] = sorted[i] = _shardIndex(positions[i]);
+
+					std::sort(sorted, sorted + 7);
+					size_t	lockCount = std::unique(sorted, sorted + 7) - sorted;
+
+					for (size_t i = 0; i < lockCount; i++)
+						_shards[sorted[i]].mutex.lock();
+
+					for (size_t i = 0; i < 7; i++) {
+						auto &	map = _shards[indices[i]].chunks;
+						auto	it = map.find(positions[i]);
+
+						chunks[i] = (it != map.end()) ? &it->second : nullptr;
+					}
+
+					fn(chunks[0], chunks + 1);
+
+					for (size_t i = lockCount; i > 0; i--)
+						_shards[sorted[i - 1]].mutex.unlock();
+				}
+
+				bool	_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred) override {
+					Shard &				shard = _shards[_shardIndex(pos)];
+					std::lock_guard<std::mutex>	lock(shard.mutex);
+					auto				it = shard.chunks.find(pos);
+
+					if (it == shard.chunks.end() || !pred(it->second))
+						return (false);
+					shard.chunks.erase(it);
+					_size--;
+					return (true);
+				}
+
+				void	_forEach(const FindCallback &fn) override {
+					for (Shard &shard : _shards) {
+						std::lock_guard<std::mutex>	lock(shard.mutex);
+
+						for (auto &chunk : shard.chunks)
+							fn(chunk.second);
+					}
+				}
+
+			public:
+				ShardedChunkMap() : _size(0) {}
+
+				void	clear() override {
+					for (Shard &shard : _shards) {
+						std::lock_guard<std::mutex>	lock(shard.mutex);
+
+						shard.chunks.clear();
+					}
+					_size = 0;
+				}
+
+				size_t	size() const override { return (_size.load()); }
+		};
+
+		typedef struct MapType {
+			std::string				name;
+			std::function<AChunkMap *()>	create;
+		} MapType;
+
+		const glm::ivec3		_radius; // The box goes from -radius to radius
+		std::vector<glm::ivec3>		_box;
+		std::vector<MapType>		_maps;
+
+		// Random position of the box, xorshift
+		glm::ivec3	_randomPosition(uint32_t &state) const {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return (_box[state % _box.size()]);
+		}
+
+		bool	_inBox(const glm::ivec3 &pos) const {
+			return (std::abs(pos.x) <= _radius.x && std::abs(pos.y) <= _radius.y && std::abs(pos.z) <= _radius.z);
+		}
+
+		// Wall time in ns of fn(thread) run on "threads" threads
+		template <typename F>
+		static double	_run(const unsigned int &threads, const F &fn) {
+			std::vector<std::thread>	workers;
+			BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+			for (unsigned int t = 0; t < threads; t++)
+				workers.emplace_back(fn, t);
+			for (std::thread &worker : workers)
+				worker.join();
+			return (elapsedNs(start));
+		}
+
+		static void	_fill(AChunkMap &map, const std::vector<glm::ivec3> &positions, const unsigned int &thread, const unsigned int &threads) {
+			for (size_t i = thread; i < positions.size(); i += threads)
+				map.findOrInsert(positions[i], [&](ChunkData &data, const bool &) { data.Wpos = positions[i]; return (true); });
+		}
+
+		// M operations per second of one operation, "valid" is cleared if a result is wrong
+		double	_measure(const MapType &type, const std::string &operation, const unsigned int &threads, bool &valid) {
+			double	total = 0;
+			size_t	operations = 0;
+
+			for (int r = 0; r < MAP_ROUNDS; r++) {
+				AChunkMap *		map = type.create();
+				std::atomic<size_t>	errors(0);
+
+				if (operation == "insert") {
+					total += _run(threads, [&](unsigned int t) { _fill(*map, _box, t, threads); });
+					operations += _box.size();
+					errors += map->size() != _box.size();
+				}
+				else {
+					_fill(*map, _box, 0, 1);
+				}
+
+				if (operation == "find") {
+					total += _run(threads, [&](unsigned int t) {
+						uint32_t	state = 0x9E3779B9 * (t + 1);
+						size_t		missing = 0;
+
+						for (int i = 0; i < MAP_FINDS_PER_THREAD; i++) {
+							glm::ivec3	pos = _randomPosition(state);
+
+							missing += !map->find(pos, [&](ChunkData &data) { missing += data.Wpos != pos; });
+						}
+						errors += missing;
+					});
+					operations += (size_t)threads * MAP_FINDS_PER_THREAD;
+				}
+				else if (operation == "neighbourhood") {
+					total += _run(threads, [&](unsigned int t) {
+						uint32_t	state = 0x9E3779B9 * (t + 1);
+						size_t		wrong = 0;
+
+						for (int i = 0; i < MAP_NEIGHBOURHOODS_PER_THREAD; i++) {
+							glm::ivec3	pos = _randomPosition(state);
+
+							map->findNeightbourhood(pos, [&](ChunkData *chunk, ChunkData **neightbours) {
+								const glm::ivec3	offsets[6] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+								wrong += !chunk || chunk->Wpos != pos;
+								for (int n = 0; n < 6; n++)
+									wrong += (neightbours[n] != nullptr) != _inBox(pos + offsets[n]);
+							});
+						}
+						errors += wrong;
+					});
+					operations += (size_t)threads * MAP_NEIGHBOURHOODS_PER_THREAD;
+				}
+				else if (operation == "mixed") {
+					total += _run(threads, [&](unsigned int t) {
+						uint32_t	state = 0x9E3779B9 * (t + 1);
+
+						for (int i = 0; i < MAP_MIXED_PER_THREAD; i++) {
+							glm::ivec3	pos = _randomPosition(state);
+
+							if (i % 10 == 0)
+								map->findOrInsert(pos, [&](ChunkData &data, const bool &) { data.Wpos = pos; return (true); });
+							else if (i % 10 == 1)
+								map->eraseIf(pos, [](ChunkData &) { return (true); });
+							else
+								map->find(pos, [](ChunkData &data) { keepResult(&data); });
+						}
+					});
+					operations += (size_t)threads * MAP_MIXED_PER_THREAD;
+				}
+
+				valid &= !errors;
+				delete map;
+			}
+			return (operations / total * 1000.0);
+		}
+
+	public:
+		ChunkMapBenchmark() : _radius(HORIZONTAL_RENDER_DISTANCE, VERTICAL_RENDER_DISTANCE, HORIZONTAL_RENDER_DISTANCE) {
+			const glm::ivec3	unloadBox = _radius * 2 + UNLOAD_DISTANCE_MARGIN * 2 + 1; // Same grid as VoxelSystem
+
+			for (int x = -_radius.x; x <= _radius.x; x++)
+				for (int y = -_radius.y; y <= _radius.y; y++)
+					for (int z = -_radius.z; z <= _radius.z; z++)
+						_box.push_back({x, y, z});
+
+			_maps.push_back({"mutex + unordered_map", []() -> AChunkMap * { return (new MutexChunkMap()); }});
+			_maps.push_back({"unordered_map shards", []() -> AChunkMap * { return (new ShardedChunkMap()); }});
+			_maps.push_back({"HashChunkMap", []() -> AChunkMap * { return (new HashChunkMap()); }});
+			_maps.push_back({"GridChunkMap", [unloadBox]() -> AChunkMap * { return (new GridChunkMap(unloadBox)); }});
+		}
+
+		bool	run() {
+			bool	success = true;
+
+			cout << "Chunk maps, " << _box.size() << " chunks loaded (M operations per second)" << endl;
+			for (const std::string operation : {"insert", "find", "neighbourhood", "mixed"}) {
+				cout << "  " << operation << endl << "    " << setw(7) << "threads";
+				for (const MapType &map : _maps)
+					cout << setw(map.name.size() + 3) << map.name;
+				cout << endl;
+
+				for (unsigned int threads = 1; threads <= benchmarkMaxThreads(); threads *= 2) {
+					cout << "    " << setw(7) << threads;
+					for (const MapType &map : _maps) {
+						bool	valid = true;
+
+						cout << setw(map.name.size() + 3) << fixed << setprecision(2) << _measure(map, operation, threads, valid);
+						if (!valid)
+							cout << " (WRONG RESULTS)";
+						success &= valid;
+					}
+					cout << endl;
+				}
+			}
+			return (success);
+		}
+};
+
+int	main(int argc, char **argv) {
+	ChunkMapBenchmark	benchmark;
+
+	initBenchmark(argc, argv);
+	return (benchmark.run() ? EXIT_SUCCESS : EXIT_FAILURE);
+}
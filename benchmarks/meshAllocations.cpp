@@ -0,0 +1,60 @@
+# include "MeshBenchmark.hpp"
+
+# include <cmath>
+# include <memory>
+# include <new>
+
+/// Defines
+# define ALLOCATION_ROUNDS	5 // Counted rounds, after the warm-up one
+
+// Global operator new of the program, counting while _counting is set.
+// Not inlined, GCC would pair their malloc / free with the new / delete expressions and warn about them.
+static bool	_counting = false;
+static size_t	_allocations = 0;
+static size_t	_allocatedBytes = 0;
+
+__attribute__((noinline)) void *	operator new(size_t size) {
+	if (_counting) {
+		_allocations++;
+		_allocatedBytes += size;
+	}
+
+	void *	ptr = malloc(size ? size : 1);
+
+	if (!ptr)
+		throw std::bad_alloc();
+	return (ptr);
+}
+
+__attribute__((noinline)) void	operator delete(void *ptr) noexcept { free(ptr); }
+void	operator delete(void *ptr, size_t) noexcept { operator delete(ptr); } // The array forms of the standard library forward to these
+
+// Allocation check of the mesher, over the non-uniform chunks of a generated region:
+// Once a first round has set up the per-worker buffers, _constructChunkMesh must not allocate anymore.
+// Only the mesh itself is counted, the snapshot is taken outside of the count.
+int	main(int argc, char **argv) {
+	uint64_t			seed = initBenchmark(argc, argv);
+	MeshBenchmark			region;
+	std::unique_ptr<MeshSnapshot>	snapshot(new MeshSnapshot);
+	std::vector<DATA_TYPE>		vertices;
+
+	vertices.reserve((pow(CHUNK_SIZE, 3) / 2) * 6); // Same as the mesh jobs
+
+	for (int r = 0; r <= ALLOCATION_ROUNDS; r++) {
+		for (const glm::ivec3 &pos : region.getMeshedChunks()) {
+			region.takeSnapshot(*snapshot, pos);
+
+			_counting = r > 0; // The first round warms up
+			MeshBenchmark::constructMesh(vertices, *snapshot);
+			_counting = false;
+		}
+	}
+
+	const size_t	meshes = ALLOCATION_ROUNDS * region.getMeshedChunks().size();
+
+	cout << "Seed " << seed << ", " << region.getMeshedChunks().size() << " chunks meshed " << ALLOCATION_ROUNDS << " times after a warm-up round" << endl;
+	cout << _allocations << " allocations (" << _allocatedBytes / 1024 << " KB) in the mesher, " << fixed << setprecision(2)
+		<< (double)_allocations / meshes << " per mesh" << (_allocations ? " | THE MESHER ALLOCATES" : "") << endl;
+
+	return (_allocations ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,63 @@
+# include "MeshBenchmark.hpp"
+
+# include <cmath>
+# include <memory>
+
+/// Defines
+# define MESH_ROUNDS	20
+
+// Meshing benchmark, over the non-uniform chunks of a generated region:
+// - Generation time of the region and hash of its blocks
+// - Snapshot and mesh time per chunk, as a mesh job takes and builds them
+// - Hash of the vertices, which must be the same on every round since the mesher reuses its buffers
+// The hashes only depend on the seed and the generation flags, compare them between two builds to check a change.
+int	main(int argc, char **argv) {
+	uint64_t			seed = initBenchmark(argc, argv);
+	MeshBenchmark			region;
+	std::unique_ptr<MeshSnapshot>	snapshot(new MeshSnapshot);
+	std::vector<DATA_TYPE>		vertices;
+	uint64_t			verticesHash = 0;
+	size_t				vertexCount = 0;
+	double				snapshotTime = 0, meshTime = 0; // in ns
+	bool				success = true;
+
+	vertices.reserve((pow(CHUNK_SIZE, 3) / 2) * 6); // Same as the mesh jobs
+
+	for (int r = 0; r < MESH_ROUNDS; r++) {
+		uint64_t	hash = BENCHMARK_HASH_INIT;
+		size_t		count = 0;
+
+		for (const glm::ivec3 &pos : region.getMeshedChunks()) {
+			BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+			region.takeSnapshot(*snapshot, pos);
+			snapshotTime += elapsedNs(start);
+
+			start = BenchmarkClock::now();
+			MeshBenchmark::constructMesh(vertices, *snapshot);
+			meshTime += elapsedNs(start);
+
+			for (const DATA_TYPE &vertex : vertices)
+				hashValue(hash, vertex);
+			count += vertices.size();
+		}
+
+		if (!r) {
+			verticesHash = hash;
+			vertexCount = count;
+		}
+		success &= hash == verticesHash && count == vertexCount;
+	}
+
+	const double	meshes = (double)MESH_ROUNDS * region.getMeshedChunks().size();
+
+	cout << "Seed " << seed << ", " << region.getChunkCount() << " chunks generated in " << fixed << setprecision(0)
+		<< region.getGenerationTime() << " ms | blocks hash " << hex << setfill('0') << setw(16) << region.hashBlocks() << setfill(' ') << dec << endl;
+	cout << region.getMeshedChunks().size() << " chunks meshed " << MESH_ROUNDS << " times, per chunk : " << setprecision(1)
+		<< "snapshot " << snapshotTime / meshes / 1000 << " us, mesh " << meshTime / meshes / 1000 << " us, total "
+		<< (snapshotTime + meshTime) / meshes / 1000 << " us" << endl;
+	cout << vertexCount << " vertices | vertices hash " << hex << setfill('0') << setw(16) << verticesHash << setfill(' ') << dec
+		<< (success ? "" : " | VERTICES CHANGED BETWEEN ROUNDS") << endl;
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,192 @@
+# include "benchmark.hpp"
+
+# include <cmath>
+# include <cstring>
+# include <vector>
+
+# include "CPUDispatch.hpp"
+
+/// Defines
+# define NOISE_SAMPLES	(32 * 32 * 32) // A whole chunk
+# define NOISE_ROUNDS	32
+# define NOISE_SCALE	20.0f // Same as the first octave of the caves
+# define NOISE_OFFSET	2048.0f // The noise is only sampled at positive coordinates
+
+// Noise kernels benchmark, the timings are in ns per sample:
+// - The gradient table of perlin2D against the sin / cos gradients it replaced
+// - The perlin2DBatch kernels, each one must match perlin2D bit for bit
+// - gradient3D against perlin3D, and the gradient3DBatch kernels that must match gradient3D bit for bit
+class	NoiseBenchmark {
+	private:
+		typedef void	(*Batch2DFunc)(const float *, const float *, float *, const size_t &);
+		typedef void	(*Batch3DFunc)(const float *, const float *, const float *, float *, const size_t &);
+
+		typedef struct Kernel2D {
+			const char *	name;
+			Batch2DFunc		func;
+		} Kernel2D;
+
+		typedef struct Kernel3D {
+			const char *	name;
+			Batch3DFunc		func;
+		} Kernel3D;
+
+		std::vector<float>	_x, _y, _z, _out, _ref;
+
+		// The gradient of perlin2D before the table, turned from the hash by sin / cos on every corner
+		static float	_trigDot(const glm::ivec2 &v1, const glm::vec2 &v2) {
+			float		angle = Noise::_perlin2DHash(v1) * (3.14159265 / ~(~0u >> 1)); // in [0, 2*Pi]
+			glm::vec2	gradiant = {sin(angle), cos(angle)};
+
+			return (glm::dot(glm::vec2{v2.x - (float)v1.x, v2.y - (float)v1.y}, gradiant));
+		}
+
+		// perlin2D with _trigDot
+		static float	_trigPerlin2D(const glm::vec2 &v) {
+			glm::ivec2	tl = {(int)v.x, (int)v.y};
+			glm::vec2	w = {v.x - (float)tl.x, v.y - (float)tl.y};
+
+			return (Noise::_perlin2DCubInterpol(glm::vec2{
+					Noise::_perlin2DCubInterpol(glm::vec2{_trigDot(tl, v), _trigDot(tl + glm::ivec2(1, 0), v)}, w.x),
+					Noise::_perlin2DCubInterpol(glm::vec2{_trigDot(tl + glm::ivec2(0, 1), v), _trigDot(tl + glm::ivec2(1, 1), v)}, w.x)},
+				w.y));
+		}
+
+		template <typename Func>
+		double	_time(const Func &func) {
+			BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+			for (int r = 0; r < NOISE_ROUNDS; r++) {
+				func();
+				keepResult(_out.data());
+			}
+			return (elapsedNs(start) / NOISE_ROUNDS / NOISE_SAMPLES);
+		}
+
+		// Bit for bit, so a NaN or a -0 is a mismatch too
+		size_t	_mismatches() {
+			size_t	count = 0;
+
+			for (size_t i = 0; i < NOISE_SAMPLES; i++)
+				count += memcmp(&_out[i], &_ref[i], sizeof(float)) != 0;
+			return (count);
+		}
+
+		static void	_print(const char *name, const double &ns) {
+			cout << "  " << left << setw(28) << name << right << fixed << setprecision(2) << setw(8) << ns << " ns per sample";
+		}
+
+		static std::vector<Kernel2D>	_kernels2D() {
+			std::vector<Kernel2D>	kernels = {{"perlin2DBatch scalar", &Noise::_perlin2DBatchScalar}};
+
+# ifdef CPU_DISPATCH_X86
+			if (CPUDispatch::getLevel() >= CPULevel::SSE2)
+				kernels.push_back({"perlin2DBatch SSE2", &Noise::_perlin2DBatchSSE2});
+			if (CPUDispatch::getLevel() >= CPULevel::AVX2)
+				kernels.push_back({"perlin2DBatch AVX2", &Noise::_perlin2DBatchAVX2});
+# endif
+			return (kernels);
+		}
+
+		static std::vector<Kernel3D>	_kernels3D() {
+			std::vector<Kernel3D>	kernels = {{"gradient3DBatch scalar", &Noise::_gradient3DBatchScalar}};
+
+# ifdef CPU_DISPATCH_X86
+			if (CPUDispatch::getLevel() >= CPULevel::SSE2)
+				kernels.push_back({"gradient3DBatch SSE2", &Noise::_gradient3DBatchSSE2});
+			if (CPUDispatch::getLevel() >= CPULevel::AVX2)
+				kernels.push_back({"gradient3DBatch AVX2", &Noise::_gradient3DBatchAVX2});
+# endif
+			return (kernels);
+		}
+
+	public:
+		// Samples every 3 blocks over a chunk at the cave scale, offset to positive coordinates as in the generation
+		NoiseBenchmark() : _x(NOISE_SAMPLES), _y(NOISE_SAMPLES), _z(NOISE_SAMPLES), _out(NOISE_SAMPLES), _ref(NOISE_SAMPLES) {
+			for (size_t i = 0; i < NOISE_SAMPLES; i++) {
+				_x[i] = (NOISE_OFFSET + (i % 32) * 3.0f + 0.37f) / NOISE_SCALE;
+				_y[i] = (NOISE_OFFSET + ((i / 32) % 32) * 3.0f + 0.61f) / NOISE_SCALE;
+				_z[i] = (NOISE_OFFSET + (i / 1024) * 3.0f + 0.13f) / NOISE_SCALE;
+			}
+		}
+
+		bool	gradientTable() {
+			float	maxDiff = 0;
+
+			cout << "Gradient table (perlin2D)" << endl;
+			_print("sin / cos gradients", _time([&]() {
+				for (size_t i = 0; i < NOISE_SAMPLES; i++)
+					_out[i] = _trigPerlin2D({_x[i], _y[i]});
+			}));
+			cout << endl;
+			_print("gradient table", _time([&]() {
+				for (size_t i = 0; i < NOISE_SAMPLES; i++)
+					_out[i] = Noise::perlin2D({_x[i], _y[i]});
+			}));
+			cout << endl;
+
+			for (size_t i = 0; i < NOISE_SAMPLES; i++)
+				maxDiff = std::max(maxDiff, fabsf(_trigPerlin2D({_x[i], _y[i]}) - Noise::perlin2D({_x[i], _y[i]})));
+			cout << "  largest difference with the sin / cos gradients : " << scientific << maxDiff << fixed << endl;
+			return (true);
+		}
+
+		bool	perlin2DKernels() {
+			bool	success = true;
+
+			cout << "perlin2DBatch kernels" << endl;
+			for (size_t i = 0; i < NOISE_SAMPLES; i++)
+				_ref[i] = Noise::perlin2D({_x[i], _y[i]});
+
+			for (const Kernel2D &kernel : _kernels2D()) {
+				_print(kernel.name, _time([&]() { kernel.func(_x.data(), _y.data(), _out.data(), NOISE_SAMPLES); }));
+
+				size_t	mismatches = _mismatches();
+				cout << " | " << (mismatches ? "MISMATCH on " + to_string(mismatches) + " samples" : "matches perlin2D") << endl;
+				success &= !mismatches;
+			}
+			return (success);
+		}
+
+		bool	gradient3DKernels() {
+			bool	success = true;
+
+			cout << "3D noise" << endl;
+			_print("perlin3D", _time([&]() {
+				for (size_t i = 0; i < NOISE_SAMPLES; i++)
+					_out[i] = Noise::perlin3D({_x[i], _y[i], _z[i]});
+			}));
+			cout << endl;
+			_print("perlin3DBatch", _time([&]() { Noise::perlin3DBatch(_x.data(), _y.data(), _z.data(), _out.data(), NOISE_SAMPLES); }));
+			cout << endl;
+			_print("gradient3D", _time([&]() {
+				for (size_t i = 0; i < NOISE_SAMPLES; i++)
+					_out[i] = Noise::gradient3D({_x[i], _y[i], _z[i]});
+			}));
+			cout << endl;
+
+			for (size_t i = 0; i < NOISE_SAMPLES; i++)
+				_ref[i] = Noise::gradient3D({_x[i], _y[i], _z[i]});
+
+			for (const Kernel3D &kernel : _kernels3D()) {
+				_print(kernel.name, _time([&]() { kernel.func(_x.data(), _y.data(), _z.data(), _out.data(), NOISE_SAMPLES); }));
+
+				size_t	mismatches = _mismatches();
+				cout << " | " << (mismatches ? "MISMATCH on " + to_string(mismatches) + " samples" : "matches gradient3D") << endl;
+				success &= !mismatches;
+			}
+			return (success);
+		}
+};
+
+int	main(int argc, char **argv) {
+	NoiseBenchmark	benchmark;
+	bool		success = true;
+
+	cout << "Seed " << initBenchmark(argc, argv) << ", " << NOISE_SAMPLES << " samples" << endl;
+	success &= benchmark.gradientTable();
+	success &= benchmark.perlin2DKernels();
+	success &= benchmark.gradient3DKernels();
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
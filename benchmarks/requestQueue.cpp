@@ -0,0 +1,197 @@
+# include "benchmark.hpp"
+
+# include <atomic>
+# include <deque>
+# include <mutex>
+# include <vector>
+
+# include "ChunkRequestQueue.hpp"
+
+/// Defines
+# define QUEUE_PUSHES_PER_PRODUCER	2000 // Distinct positions pushed by each producer
+# define QUEUE_CONSUMERS	2
+# define QUEUE_ROUNDS	5
+
+// ChunkRequestQueue benchmark:
+// - Cost of a push against the number of queued requests, with a single thread
+// - Contention, 1 to N producers pushing distinct positions while QUEUE_CONSUMERS threads pop and release them.
+//   Every request must be popped exactly once.
+// - Coalescing, a DELETE merged into a queued CREATE_UPDATE must be popped alone and leave no slot behind.
+// Both are compared with the mutex-guarded deque searched with std::find that VoxelSystem used before the queue.
+class	ChunkRequestQueueBenchmark {
+	private:
+		// The request deque of VoxelSystem before ChunkRequestQueue
+		class	DequeQueue {
+			private:
+				std::deque<ChunkRequest>	_requests;
+				std::mutex			_mutex;
+
+			public:
+				void	push(const ChunkRequest &request) {
+					std::lock_guard<std::mutex>	lock(_mutex);
+
+					if (std::find(_requests.begin(), _requests.end(), request) == _requests.end())
+						_requests.push_back(request);
+				}
+
+				bool	pop(ChunkRequest &request) {
+					std::lock_guard<std::mutex>	lock(_mutex);
+
+					if (_requests.empty())
+						return (false);
+					request = _requests.front();
+					_requests.pop_front();
+					return (true);
+				}
+		};
+
+		// Distinct position of the i-th request of a producer
+		static glm::ivec3	_position(const unsigned int &producer, const int &i) {
+			return {i % 64 - 32, (int)producer, i / 64};
+		}
+
+		// ns per push, all the requests queued with no consumer
+		template <typename Queue>
+		static double	_fillTime(const int &count) {
+			double	total = 0;
+
+			for (int r = 0; r < QUEUE_ROUNDS; r++) {
+				Queue				queue;
+				BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+				for (int i = 0; i < count; i++)
+					queue.push(ChunkRequest{_position(0, i), ChunkAction::CREATE_UPDATE});
+				total += elapsedNs(start);
+			}
+			return (total / QUEUE_ROUNDS / count);
+		}
+
+		static bool	_pop(ChunkRequestQueue &queue, ChunkRequest &request) {
+			RequestTicket	ticket;
+
+			if (!queue.pop(request, ticket))
+				return (false);
+			queue.release(request.first, ticket);
+			return (true);
+		}
+
+		static bool	_pop(DequeQueue &queue, ChunkRequest &request) {
+			return (queue.pop(request));
+		}
+
+		// ns per push with "producers" threads pushing, return false if a request was lost or popped twice
+		template <typename Queue>
+		static bool	_contention(const unsigned int &producers, double &pushNs) {
+			const size_t		total = producers * QUEUE_PUSHES_PER_PRODUCER;
+			Queue			queue;
+			std::vector<std::atomic<int>>	popped(total);
+			std::atomic<size_t>	poppedCount(0);
+			std::vector<double>	pushTimes(producers); // Per producer, in ns
+			std::vector<std::thread>	threads;
+
+			for (std::atomic<int> &count : popped)
+				count = 0;
+
+			for (int c = 0; c < QUEUE_CONSUMERS; c++) {
+				threads.emplace_back([&]() {
+					ChunkRequest	request;
+
+					while (poppedCount.load() < total) {
+						if (!_pop(queue, request)) {
+							std::this_thread::yield();
+							continue;
+						}
+						popped[request.first.y * QUEUE_PUSHES_PER_PRODUCER + request.first.z * 64 + request.first.x + 32]++;
+						poppedCount++;
+					}
+				});
+			}
+			for (unsigned int p = 0; p < producers; p++) {
+				threads.emplace_back([&, p]() {
+					BenchmarkClock::time_point	start = BenchmarkClock::now();
+
+					for (int i = 0; i < QUEUE_PUSHES_PER_PRODUCER; i++)
+						queue.push(ChunkRequest{_position(p, i), ChunkAction::CREATE_UPDATE});
+					pushTimes[p] = elapsedNs(start);
+				});
+			}
+			for (std::thread &thread : threads)
+				thread.join();
+
+			pushNs = 0;
+			for (double time : pushTimes)
+				pushNs += time / total;
+			for (std::atomic<int> &count : popped)
+				if (count != 1)
+					return (false);
+			return (true);
+		}
+
+	public:
+		static void	fill() {
+			cout << "Push cost against the queued requests, 1 thread (ns per push)" << endl;
+			cout << "  " << setw(8) << "queued" << setw(20) << "ChunkRequestQueue" << setw(16) << "deque + find" << endl;
+			for (int count = 1000; count <= 16000; count *= 4) {
+				cout << "  " << setw(8) << count << fixed << setprecision(1)
+					<< setw(20) << _fillTime<ChunkRequestQueue>(count)
+					<< setw(16) << _fillTime<DequeQueue>(count) << endl;
+			}
+		}
+
+		// The DELETE goes first, once it is released the CREATE_UPDATE entry left in the heap has no slot anymore
+		static bool	coalescing() {
+			ChunkRequestQueue	queue;
+			ChunkRequest		request;
+			size_t			deletes = 0, others = 0;
+
+			for (int i = 0; i < QUEUE_PUSHES_PER_PRODUCER; i++) {
+				queue.push(ChunkRequest{_position(0, i), ChunkAction::CREATE_UPDATE});
+				queue.push(ChunkRequest{_position(0, i), ChunkAction::DELETE});
+			}
+			while (_pop(queue, request))
+				(request.second == ChunkAction::DELETE) ? deletes++ : others++;
+
+			bool	success = deletes == QUEUE_PUSHES_PER_PRODUCER && !others && queue._slots.empty() && queue._heap.empty();
+
+			cout << "Coalescing, " << QUEUE_PUSHES_PER_PRODUCER << " CREATE_UPDATE merged with a DELETE : "
+				<< deletes << " deletes and " << others << " others popped, " << queue._slots.size() << " slots left"
+				<< (success ? "" : " | WRONG") << endl;
+			return (success);
+		}
+
+		static bool	contention() {
+			bool	success = true;
+
+			cout << "Contention, " << QUEUE_CONSUMERS << " consumers, " << QUEUE_PUSHES_PER_PRODUCER << " pushes per producer (ns per push)" << endl;
+			cout << "  " << setw(9) << "producers" << setw(20) << "ChunkRequestQueue" << setw(16) << "deque + find" << endl;
+			for (unsigned int producers = 1; producers <= benchmarkMaxThreads(); producers *= 2) {
+				double	queueNs = 0, dequeNs = 0;
+				bool	valid = true;
+
+				for (int r = 0; r < QUEUE_ROUNDS; r++) {
+					double	ns;
+
+					valid &= _contention<ChunkRequestQueue>(producers, ns);
+					queueNs += ns / QUEUE_ROUNDS;
+					_contention<DequeQueue>(producers, ns);
+					dequeNs += ns / QUEUE_ROUNDS;
+				}
+				cout << "  " << setw(9) << producers << fixed << setprecision(1)
+					<< setw(20) << queueNs << setw(16) << dequeNs
+					<< (valid ? "" : " | LOST OR DUPLICATED REQUESTS") << endl;
+				success &= valid;
+			}
+			return (success);
+		}
+};
+
+int	main(int argc, char **argv) {
+	bool	success = true;
+
+	initBenchmark(argc, argv);
+	success &= ChunkRequestQueueBenchmark::coalescing();
+	ChunkRequestQueueBenchmark::fill();
+	success &= ChunkRequestQueueBenchmark::contention();
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
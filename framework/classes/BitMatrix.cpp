@@ -0,0 +1,123 @@
+# include "BitMatrix.hpp"
+# include "CPUDispatch.hpp"
+
+# ifdef CPU_DISPATCH_X86
+#  include <immintrin.h>
+# endif
+
+BitMatrix::Transpose32Func	BitMatrix::_transpose32Func = SELECT_KERNEL(&_transpose32Scalar, &_transpose32SSE2, &_transpose32AVX2);
+
+// The 16 x 16 blocks are swapped first, then the 8 x 8 blocks inside each of them, down to single bits
+void	BitMatrix::_transpose32Scalar(uint32_t *rows)
+{
+	uint32_t	mask = 0x0000FFFF;
+
+	for (int width = 16; width; width >>= 1, mask ^= mask << width) {
+		for (int k = 0; k < 32; k = (k + width + 1) & ~width) {
+			const uint32_t	swapped = ((rows[k] >> width) ^ rows[k + width]) & mask;
+
+			rows[k] ^= swapped << width;
+			rows[k + width] ^= swapped;
+		}
+	}
+}
+
+# ifdef CPU_DISPATCH_X86
+
+// The SIMD kernels gather the byte b of every row in a vector, so movemask reads the bit 8 * b + 7 of all the rows,
+// which is the row 8 * b + 7 of the transpose. Each shift by one then brings the next lower bit under the mask.
+
+__attribute__((target("sse2")))
+void	BitMatrix::_transpose32SSE2(uint32_t *rows)
+{
+	uint32_t	out[32] = {0};
+
+	// 16 rows at a time, each half of the output rows
+	for (int half = 0; half < 2; half++) {
+		__m128i	a0 = _mm_loadu_si128((const __m128i *)(rows + half * 16));
+		__m128i	a1 = _mm_loadu_si128((const __m128i *)(rows + half * 16 + 4));
+		__m128i	a2 = _mm_loadu_si128((const __m128i *)(rows + half * 16 + 8));
+		__m128i	a3 = _mm_loadu_si128((const __m128i *)(rows + half * 16 + 12));
+
+		// 4 x 4 transpose of the rows: a0 holds the rows 0, 4, 8, 12, a1 the rows 1, 5, 9, 13, ...
+		__m128i	t0 = _mm_unpacklo_epi32(a0, a1);
+		__m128i	t1 = _mm_unpackhi_epi32(a0, a1);
+		__m128i	t2 = _mm_unpacklo_epi32(a2, a3);
+		__m128i	t3 = _mm_unpackhi_epi32(a2, a3);
+
+		a0 = _mm_unpacklo_epi64(t0, t2);
+		a1 = _mm_unpackhi_epi64(t0, t2);
+		a2 = _mm_unpacklo_epi64(t1, t3);
+		a3 = _mm_unpackhi_epi64(t1, t3);
+
+		// Interleave the bytes until each vector holds one byte of the 16 rows, in order
+		__m128i	u0 = _mm_unpacklo_epi8(a0, a2);
+		__m128i	u1 = _mm_unpackhi_epi8(a0, a2);
+		__m128i	u2 = _mm_unpacklo_epi8(a1, a3);
+		__m128i	u3 = _mm_unpackhi_epi8(a1, a3);
+
+		__m128i	v0 = _mm_unpacklo_epi8(u0, u2);
+		__m128i	v1 = _mm_unpackhi_epi8(u0, u2);
+		__m128i	v2 = _mm_unpacklo_epi8(u1, u3);
+		__m128i	v3 = _mm_unpackhi_epi8(u1, u3);
+
+		__m128i	w0 = _mm_unpacklo_epi32(v0, v1);
+		__m128i	w1 = _mm_unpackhi_epi32(v0, v1);
+		__m128i	w2 = _mm_unpacklo_epi32(v2, v3);
+		__m128i	w3 = _mm_unpackhi_epi32(v2, v3);
+
+		__m128i	bytes[4] = {
+			_mm_unpacklo_epi64(w0, w2),
+			_mm_unpackhi_epi64(w0, w2),
+			_mm_unpacklo_epi64(w1, w3),
+			_mm_unpackhi_epi64(w1, w3)
+		};
+
+		for (int b = 0; b < 4; b++) {
+			for (int bit = 7; bit >= 0; bit--) {
+				out[b * 8 + bit] |= (uint32_t)_mm_movemask_epi8(bytes[b]) << (half * 16);
+				bytes[b] = _mm_slli_epi64(bytes[b], 1);
+			}
+		}
+	}
+
+	for (int i = 0; i < 32; i++)
+		rows[i] = out[i];
+}
+
+__attribute__((target("avx2")))
+void	BitMatrix::_transpose32AVX2(uint32_t *rows)
+{
+	// Group the bytes of the 4 rows of each lane: byte b of the rows in the dword b of the lane
+	const __m256i	group = _mm256_setr_epi8(
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	// The lanes hold the rows 0-3, 8-11, ... and 4-7, 12-15, ... once transposed, interleave them back in order
+	const __m256i	order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	__m256i	y0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(rows)), group);
+	__m256i	y1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(rows + 8)), group);
+	__m256i	y2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(rows + 16)), group);
+	__m256i	y3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(rows + 24)), group);
+
+	__m256i	t0 = _mm256_unpacklo_epi32(y0, y1);
+	__m256i	t1 = _mm256_unpackhi_epi32(y0, y1);
+	__m256i	t2 = _mm256_unpacklo_epi32(y2, y3);
+	__m256i	t3 = _mm256_unpackhi_epi32(y2, y3);
+
+	__m256i	bytes[4] = {
+		_mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(t0, t2), order),
+		_mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(t0, t2), order),
+		_mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(t1, t3), order),
+		_mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(t1, t3), order)
+	};
+
+	for (int b = 0; b < 4; b++) {
+		for (int bit = 7; bit >= 0; bit--) {
+			rows[b * 8 + bit] = (uint32_t)_mm256_movemask_epi8(bytes[b]);
+			bytes[b] = _mm256_slli_epi64(bytes[b], 1);
+		}
+	}
+}
+
+# endif
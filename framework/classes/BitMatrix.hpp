@@ -0,0 +1,26 @@
+# pragma once
+
+/// System includes
+# include <cstdint>
+
+// Bit matrix operations on the occupancy masks, 32 rows of 32 bits.
+// The kernels are picked for the running CPU at startup, all of them give the same results.
+class	BitMatrix {
+	friend class BitMatrixBenchmark; // benchmarks/bitMatrix.cpp, times and checks every kernel
+
+	private:
+		typedef void	(*Transpose32Func)(uint32_t *);
+
+		static Transpose32Func	_transpose32Func; // Best kernel for the running CPU
+
+		BitMatrix() {}
+		~BitMatrix() {}
+
+		static void	_transpose32Scalar(uint32_t *rows);
+		static void	_transpose32SSE2(uint32_t *rows);
+		static void	_transpose32AVX2(uint32_t *rows);
+
+	public:
+		// In place, bit j of rows[i] becomes bit i of rows[j]
+		static void	transpose32(uint32_t *rows) { _transpose32Func(rows); }
+};
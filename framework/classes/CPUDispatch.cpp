@@ -0,0 +1,13 @@
+# include "CPUDispatch.hpp"
+
+CPULevel	CPUDispatch::getLevel()
+{
+# ifdef CPU_DISPATCH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return (CPULevel::AVX2);
+	if (__builtin_cpu_supports("sse2"))
+		return (CPULevel::SSE2);
+# endif
+	return (CPULevel::SCALAR);
+}
@@ -0,0 +1,42 @@
+# pragma once
+
+/// Defines
+# if defined(__x86_64__) || defined(__i386__)
+#  define CPU_DISPATCH_X86
+# endif
+
+// Widest of the given kernels supported by the running CPU.
+// The SSE2 and AVX2 kernels are only compiled on x86, elsewhere only the scalar one is named.
+# ifdef CPU_DISPATCH_X86
+#  define SELECT_KERNEL(scalar, sse2, avx2)	CPUDispatch::select(scalar, sse2, avx2)
+# else
+#  define SELECT_KERNEL(scalar, sse2, avx2)	(scalar)
+# endif
+
+enum class	CPULevel {
+	SCALAR = 0,
+	SSE2,
+	AVX2
+};
+
+// Instruction set detection shared by the SIMD kernel tables (Noise, BitMatrix, layer uniformity, ...).
+// Each table picks its kernel once at startup through SELECT_KERNEL.
+class	CPUDispatch {
+	private:
+		CPUDispatch() {}
+		~CPUDispatch() {}
+
+	public:
+		// Widest instruction set of the running CPU the kernels are written for.
+		// Safe to call during the static initialization, nothing is cached.
+		static CPULevel	getLevel();
+
+		template <typename Func>
+		static Func	select(const Func &scalar, const Func &sse2, const Func &avx2) {
+			switch (getLevel()) {
+				case CPULevel::AVX2:	return (avx2);
+				case CPULevel::SSE2:	return (sse2);
+				default:		return (scalar);
+			}
+		}
+};
@@ -68,6 +68,19 @@ void	Camera::_updateProjectionMatrix() {
 
 /// Getters
 
+// Extract a normalized frustum plane from the View-Projection matrix
+static inline glm::vec4	extractPlane(const glm::mat4 &m, int row, int sign) {
+	glm::vec4	plane = {
+		m[0][3] + sign * m[0][row],
+		m[1][3] + sign * m[1][row],
+		m[2][3] + sign * m[2][row],
+		m[3][3] + sign * m[3][row]
+	};
+
+	float	len = glm::length(glm::vec3(plane)); // normalize by xyz length
+	return plane / len;
+}
+
 // Return the camera information
 const CameraInfo	&Camera::getCameraInfo() const {
 	return _cameraInfo;
@@ -88,10 +101,32 @@ glm::mat4	Camera::getProjectionMatrix() {
 	return _projectionMatrix;
 }
 
+// Return the planes of the view frustum
+Frustum	Camera::getFrustum() {
+	glm::mat4	VP = _projectionMatrix * _viewMatrix;
+
+	return Frustum{
+		extractPlane(VP, 0, +1), // Left
+		extractPlane(VP, 0, -1), // Right
+		extractPlane(VP, 1, +1), // Bottom
+		extractPlane(VP, 1, -1), // Top
+		extractPlane(VP, 2, +1), // Near
+		extractPlane(VP, 2, -1)  // Far
+	};
+}
+
 // Return the projection matrix * view matrix
 Camera::operator glm::mat4() {
 	return _projectionMatrix * _viewMatrix;
 }
+
+// Return false if the sphere is entirely outside of one of the frustum planes
+bool	Camera::isSphereInFrustum(const Frustum &frustum, const glm::vec3 &center, const float &radius) {
+	for (const glm::vec4 &plane : frustum)
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	return true;
+}
 /// ---
 
 
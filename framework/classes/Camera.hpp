@@ -2,6 +2,7 @@
 
 /// System includes
 # include <iostream>
+# include <array>
 
 /// Dependencies
 # include "glm/glm.hpp"
@@ -31,6 +32,9 @@ typedef struct ProjectionInfo {
 	float	far          = 100.0f;
 } ProjectionInfo;
 
+// Planes of the view frustum (left, right, bottom, top, near, far), normals pointing inside
+typedef std::array<glm::vec4, 6> Frustum;
+
 // Class for camera management, handle the view and projection matrices and the camera position
 class Camera {
 	private:
@@ -60,8 +64,11 @@ class Camera {
 
 		glm::mat4	getViewMatrix();
 		glm::mat4	getProjectionMatrix();
+		Frustum		getFrustum();
 		operator	glm::mat4();
 
+		static bool	isSphereInFrustum(const Frustum &frustum, const glm::vec3 &center, const float &radius);
+
 		/// Setters
 
 		void	setCameraInfo(const CameraInfo &cameraInfo);
@@ -0,0 +1,195 @@
+# include <chrono>
+# include <iostream>
+
+# include "JobSystem.hpp"
+
+thread_local JobSystem *	JobSystem::_currentSystem = nullptr;
+thread_local int		JobSystem::_currentWorker = JOB_ANY_WORKER;
+
+static inline uint64_t	elapsedNano(const std::chrono::steady_clock::time_point &start)
+{
+	return (std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+//// JobSystem class
+
+/// Constructors & Destructors
+JobSystem::JobSystem(const uint32_t &workerCount) : _workers(new Worker[workerCount]), _workerCount(workerCount), _queuedJobs(0), _sleepers(0), _quitting(false)
+{
+	for (uint32_t i = 0; i < _workerCount; i++)
+		_workers[i].thread = std::thread(&JobSystem::_workerRoutine, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+	delete [] _workers;
+}
+/// ---
+
+/// Private Methods
+void	JobSystem::_workerRoutine(const uint32_t &index)
+{
+	Worker &	worker = _workers[index];
+	Job		job;
+
+	_currentSystem = this;
+	_currentWorker = index;
+
+	while (!_quitting) {
+		if (_findJob(index, job)) {
+			auto	start = std::chrono::steady_clock::now();
+
+			job();
+			job = nullptr;
+			worker.busyTime.fetch_add(elapsedNano(start), std::memory_order_relaxed);
+			worker.jobCount.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		// A job is counted but not found yet (still being published or taken by another worker), retry without parking
+		if (_queuedJobs.load()) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Park until a job is submitted. Submitters bump _queuedJobs before reading _sleepers
+		// and the workers do the opposite, so a wakeup can not be lost.
+		std::unique_lock<std::mutex>	lock(_sleepMutex);
+
+		_sleepers.fetch_add(1);
+
+		auto	start = std::chrono::steady_clock::now();
+
+		_sleepCondition.wait(lock, [this]() { return (_queuedJobs.load() || _quitting.load()); });
+		worker.idleTime.fetch_add(elapsedNano(start), std::memory_order_relaxed);
+		_sleepers.fetch_sub(1);
+	}
+}
+
+// Own deque first (newest job), then the injection queue, then steal the oldest job of another worker.
+// The first steal pass skips the deques in use, the second one waits for them if a job is still queued somewhere.
+bool	JobSystem::_findJob(const uint32_t &index, Job &job)
+{
+	Worker &	worker = _workers[index];
+
+	if (!_queuedJobs.load(std::memory_order_relaxed))
+		return (false);
+
+	worker.mutex.lock();
+	if (worker.jobs.size()) {
+		job = std::move(worker.jobs.back());
+		worker.jobs.pop_back();
+		worker.mutex.unlock();
+		_queuedJobs.fetch_sub(1);
+		return (true);
+	}
+	worker.mutex.unlock();
+
+	_injectionMutex.lock();
+	if (_injectionQueue.size()) {
+		job = std::move(_injectionQueue.front());
+		_injectionQueue.pop_front();
+		_injectionMutex.unlock();
+		_queuedJobs.fetch_sub(1);
+		return (true);
+	}
+	_injectionMutex.unlock();
+
+	for (int pass = 0; pass < 2 && _queuedJobs.load(); pass++) {
+		for (uint32_t i = 1; i < _workerCount; i++) {
+			Worker &	victim = _workers[(index + i) % _workerCount];
+
+			if (pass)
+				victim.mutex.lock();
+			else if (!victim.mutex.try_lock())
+				continue;
+			if (victim.jobs.size()) {
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				victim.mutex.unlock();
+				_queuedJobs.fetch_sub(1);
+				worker.stealCount.fetch_add(1, std::memory_order_relaxed);
+				return (true);
+			}
+			victim.mutex.unlock();
+		}
+	}
+	return (false);
+}
+/// ---
+
+/// Public methods
+void	JobSystem::submit(const Job &job, const int &affinity)
+{
+	int	target = affinity;
+
+	if (target < 0 || target >= (int)_workerCount)
+		target = (_currentSystem == this) ? _currentWorker : JOB_ANY_WORKER;
+
+	// Counted before being published, a worker taking it right away can not bring the count below 0
+	_queuedJobs.fetch_add(1);
+	if (target == JOB_ANY_WORKER) {
+		_injectionMutex.lock();
+		_injectionQueue.push_back(job);
+		_injectionMutex.unlock();
+	}
+	else {
+		_workers[target].mutex.lock();
+		_workers[target].jobs.push_back(job);
+		_workers[target].mutex.unlock();
+	}
+
+	if (_sleepers.load()) {
+		_sleepMutex.lock();
+		_sleepMutex.unlock();
+		_sleepCondition.notify_one();
+	}
+}
+
+void	JobSystem::stop()
+{
+	if (_quitting.exchange(true))
+		return ;
+
+	_sleepMutex.lock();
+	_sleepMutex.unlock();
+	_sleepCondition.notify_all();
+
+	for (uint32_t i = 0; i < _workerCount; i++)
+		_workers[i].thread.join();
+}
+
+uint32_t	JobSystem::getWorkerCount() const
+{
+	return (_workerCount);
+}
+
+WorkerStats	JobSystem::getWorkerStats(const uint32_t &index) const
+{
+	const Worker &	worker = _workers[index];
+
+	return (WorkerStats{
+		worker.busyTime.load(std::memory_order_relaxed),
+		worker.idleTime.load(std::memory_order_relaxed),
+		worker.jobCount.load(std::memory_order_relaxed),
+		worker.stealCount.load(std::memory_order_relaxed)
+	});
+}
+
+void	JobSystem::printStats() const
+{
+	for (uint32_t i = 0; i < _workerCount; i++) {
+		WorkerStats	stats = getWorkerStats(i);
+		uint64_t	total = stats.busyTime + stats.idleTime;
+
+		std::cout << "Worker " << i << ": " << stats.jobCount << " jobs (" << stats.stealCount << " stolen), "
+			<< stats.busyTime / 1000000 << "ms busy, " << stats.idleTime / 1000000 << "ms idle";
+		if (total)
+			std::cout << " (" << stats.busyTime * 100 / total << "% utilization)";
+		std::cout << std::endl;
+	}
+}
+/// ---
+
+//// ---
@@ -0,0 +1,73 @@
+# pragma once
+
+/// Defines
+# define JOB_ANY_WORKER	-1
+
+/// System includes
+# include <atomic>
+# include <condition_variable>
+# include <cstdint>
+# include <deque>
+# include <functional>
+# include <mutex>
+# include <thread>
+
+typedef std::function<void()>	Job;
+
+typedef struct WorkerStats {
+	uint64_t	busyTime; // in ns, spent running jobs
+	uint64_t	idleTime; // in ns, spent parked with nothing to do
+	uint64_t	jobCount;
+	uint64_t	stealCount; // Jobs taken from another worker deque
+} WorkerStats;
+
+// Work-stealing job scheduler.
+// Each worker has its own deque: it runs its most recent jobs first and idle workers steal the oldest ones.
+// Jobs submitted from outside of the workers go through a global injection queue, served in order.
+// Workers with nothing to do are parked on a condition variable until a job is submitted.
+class	JobSystem {
+	private:
+		typedef struct alignas(64) Worker {
+			std::thread		thread;
+			std::deque<Job>		jobs;
+			std::mutex		mutex;
+			std::atomic<uint64_t>	busyTime{0};
+			std::atomic<uint64_t>	idleTime{0};
+			std::atomic<uint64_t>	jobCount{0};
+			std::atomic<uint64_t>	stealCount{0};
+		} Worker;
+
+		Worker *	_workers;
+		uint32_t	_workerCount;
+
+		std::deque<Job>	_injectionQueue;
+		std::mutex	_injectionMutex;
+
+		std::atomic<size_t>	_queuedJobs;
+		std::atomic<uint32_t>	_sleepers;
+		std::atomic<bool>	_quitting;
+		std::mutex		_sleepMutex;
+		std::condition_variable	_sleepCondition;
+
+		// Worker running on the current thread, if any
+		static thread_local JobSystem *	_currentSystem;
+		static thread_local int		_currentWorker;
+
+		void	_workerRoutine(const uint32_t &index);
+		bool	_findJob(const uint32_t &index, Job &job);
+
+	public:
+		JobSystem(const uint32_t &workerCount);
+		~JobSystem();
+
+		// Queue a job. Without affinity, a job submitted by a worker stays in its own deque.
+		// The affinity is a hint: the job goes to that worker deque, but can still be stolen.
+		void	submit(const Job &job, const int &affinity = JOB_ANY_WORKER);
+
+		// Wait for the running jobs and join the workers, the queued jobs are dropped
+		void	stop();
+
+		uint32_t	getWorkerCount() const;
+		WorkerStats	getWorkerStats(const uint32_t &index) const;
+		void		printStats() const;
+};
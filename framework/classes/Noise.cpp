@@ -1,8 +1,18 @@
 
+# include <cmath>
+# include <vector>
+
 # include "Noise.hpp"
 
 unsigned int	g_randomFactor = 0;
 
+float	Noise::_gradientsX[NOISE_GRADIENT_COUNT];
+float	Noise::_gradientsY[NOISE_GRADIENT_COUNT];
+
+const float	Noise::_gradients3DX[16] = {1, -1, 1, -1, 1, -1, 1, -1, 0, 0, 0, 0, 1, -1, 0, 0};
+const float	Noise::_gradients3DY[16] = {1, 1, -1, -1, 0, 0, 0, 0, 1, -1, 1, -1, 1, 1, -1, -1};
+const float	Noise::_gradients3DZ[16] = {0, 0, 0, 0, 1, 1, -1, -1, 1, 1, -1, -1, 0, 0, 1, -1};
+
 void	Noise::setSeed(void *arg) {
 	uint64_t	*seed = (uint64_t *)arg;
 
@@ -13,6 +23,16 @@ void	Noise::setSeed(const uint64_t &seed)
 {
 	srand(seed);
 	g_randomFactor = 1 + rand();
+
+	// Each entry is the direction at the center of the angle range mapped to it.
+	// The seed is already mixed in the lattice hash, so the table only holds directions.
+	for (uint32_t i = 0; i < NOISE_GRADIENT_COUNT; i++) {
+		uint32_t	hash = (i << (32 - NOISE_GRADIENT_BITS)) | (1u << (31 - NOISE_GRADIENT_BITS));
+		double		angle = hash * (3.14159265 / ~(~0u >> 1)); // in [0, 2*Pi]
+
+		_gradientsX[i] = sin(angle);
+		_gradientsY[i] = cos(angle);
+	}
 }
 
 float	Noise::perlin2D(const glm::vec2 &v)
@@ -43,6 +63,17 @@ float	Noise::perlin2D(const glm::vec2 &v)
 		wVector.y));
 }
 
+void	Noise::perlin2DBatch(const float *x, const float *y, float *out, const size_t &count)
+{
+	_perlin2DBatchFunc(x, y, out, count);
+}
+
+void	Noise::_perlin2DBatchScalar(const float *x, const float *y, float *out, const size_t &count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = perlin2D({x[i], y[i]});
+}
+
 float	Noise::_perlin2DDot(const glm::ivec2 &v1, const glm::vec2 &v2)
 {
 	glm::vec2	gradiant = _perlin2DRandomGradiant(v1);
@@ -56,7 +87,7 @@ float	Noise::_perlin2DCubInterpol(const glm::vec2 &v, const float &weight)
 	return ((v.y - v.x) * (3.0f - weight * 2.0f) * weight * weight + v.x);
 }
 
-glm::vec2	Noise::_perlin2DRandomGradiant(const glm::ivec2 &v)
+uint32_t	Noise::_perlin2DHash(const glm::ivec2 &v)
 {
 	const unsigned int	w = 8 * sizeof(unsigned);
 	const unsigned int	s = w / 2; 
@@ -69,9 +100,15 @@ glm::vec2	Noise::_perlin2DRandomGradiant(const glm::ivec2 &v)
  
 	a ^= b << s | b >> (w - s);
 	a *= 2048419325;
-	float	random = a * (3.14159265 / ~(~0u >> 1)); // in [0, 2*Pi]
-    
-	return  glm::vec2{sin(random), cos(random)};
+
+	return (a);
+}
+
+glm::vec2	Noise::_perlin2DRandomGradiant(const glm::ivec2 &v)
+{
+	uint32_t	i = _perlin2DHash(v) >> (32 - NOISE_GRADIENT_BITS);
+
+	return  glm::vec2{_gradientsX[i], _gradientsY[i]};
 }
 
 float	Noise::perlin3D(const glm::vec3 &v)
@@ -87,3 +124,81 @@ float	Noise::perlin3D(const glm::vec3 &v)
 	float	abc = ab + bc + ac + ba + cb + ca;
 	return (abc / 6.0f);
 }
+
+void	Noise::perlin3DBatch(const float *x, const float *y, const float *z, float *out, const size_t &count)
+{
+	// Reused by every batch of the thread, it only grows
+	static thread_local std::vector<float>	scratch;
+
+	scratch.resize(count);
+
+	float	*tmp = scratch.data();
+
+	// Same axis permutations and summation order as perlin3D
+	const float	*axis[6][2] = {{x, y}, {y, z}, {x, z}, {y, x}, {z, y}, {z, x}};
+
+	perlin2DBatch(axis[0][0], axis[0][1], out, count);
+	for (int p = 1; p < 6; p++) {
+		perlin2DBatch(axis[p][0], axis[p][1], tmp, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] += tmp[i];
+	}
+	for (size_t i = 0; i < count; i++)
+		out[i] /= 6.0f;
+}
+
+uint32_t	Noise::_gradient3DHash(const glm::ivec3 &v)
+{
+	unsigned int	a = v.x + g_randomFactor, b = v.y + g_randomFactor, c = v.z + g_randomFactor;
+
+	a *= 3284157443;
+
+	b ^= a << 16 | a >> 16;
+	b *= 1911520717;
+
+	c ^= b << 16 | b >> 16;
+	c *= 2048419325;
+
+	a ^= c << 16 | c >> 16;
+	a *= 3284157443;
+
+	return (a);
+}
+
+float	Noise::gradient3D(const glm::vec3 &v)
+{
+	glm::vec3	floored = {floorf(v.x), floorf(v.y), floorf(v.z)};
+	glm::ivec3	cell = glm::ivec3(floored);
+	glm::vec3	w = v - floored;
+	float		d[8];
+
+	// Dot product of each cell corner gradient with the offset to that corner
+	for (int i = 0; i < 8; i++) {
+		glm::ivec3	corner = {i & 1, (i >> 1) & 1, (i >> 2) & 1};
+		uint32_t	g = _gradient3DHash(cell + corner) >> 28;
+
+		d[i] = (w.x - (float)corner.x) * _gradients3DX[g] + (w.y - (float)corner.y) * _gradients3DY[g] + (w.z - (float)corner.z) * _gradients3DZ[g];
+	}
+
+	// Interpolate along x, then y, then z
+	float	x00 = _perlin2DCubInterpol({d[0], d[1]}, w.x);
+	float	x10 = _perlin2DCubInterpol({d[2], d[3]}, w.x);
+	float	x01 = _perlin2DCubInterpol({d[4], d[5]}, w.x);
+	float	x11 = _perlin2DCubInterpol({d[6], d[7]}, w.x);
+
+	float	y0 = _perlin2DCubInterpol({x00, x10}, w.y);
+	float	y1 = _perlin2DCubInterpol({x01, x11}, w.y);
+
+	return (_perlin2DCubInterpol({y0, y1}, w.z));
+}
+
+void	Noise::gradient3DBatch(const float *x, const float *y, const float *z, float *out, const size_t &count)
+{
+	_gradient3DBatchFunc(x, y, z, out, count);
+}
+
+void	Noise::_gradient3DBatchScalar(const float *x, const float *y, const float *z, float *out, const size_t &count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = gradient3D({x[i], y[i], z[i]});
+}
@@ -1,7 +1,12 @@
 # pragma once
 
+/// Defines
+# define NOISE_GRADIENT_BITS	12
+# define NOISE_GRADIENT_COUNT	(1 << NOISE_GRADIENT_BITS) // Quantized gradient directions
+
 /// System includes
 # include <cstdlib>
+# include <cstdint>
 
 /// Dependencies
 # include <glm/glm.hpp>
@@ -10,18 +15,56 @@
 extern unsigned int	g_randomFactor;
 
 class	Noise {
+	friend class NoiseBenchmark; // benchmarks/noise.cpp, times the kernels one by one
+
 	private:
+		typedef void	(*Perlin2DBatchFunc)(const float *, const float *, float *, const size_t &);
+		typedef void	(*Gradient3DBatchFunc)(const float *, const float *, const float *, float *, const size_t &);
+
+		static Perlin2DBatchFunc	_perlin2DBatchFunc; // Best kernels for the running CPU
+		static Gradient3DBatchFunc	_gradient3DBatchFunc;
+
+		// Unit gradients indexed by the top bits of the lattice hash, stored as separate x and y for gathers
+		static float	_gradientsX[NOISE_GRADIENT_COUNT];
+		static float	_gradientsY[NOISE_GRADIENT_COUNT];
+
 		Noise() {}
 		~Noise() {}
 
 		static float		_perlin2DDot(const glm::ivec2 &v1, const glm::vec2 &v2);
 		static float		_perlin2DCubInterpol(const glm::vec2 &v, const float &weight);
+		// Cube edges directions, 4 of them repeated, indexed by the top 4 bits of the 3D lattice hash
+		static const float	_gradients3DX[16];
+		static const float	_gradients3DY[16];
+		static const float	_gradients3DZ[16];
+
+		static uint32_t		_perlin2DHash(const glm::ivec2 &v);
+		static uint32_t		_gradient3DHash(const glm::ivec3 &v);
 		static glm::vec2	_perlin2DRandomGradiant(const glm::ivec2 &v);
 
+		// Batch kernels, all of them give the exact same results as perlin2D
+		static void	_perlin2DBatchScalar(const float *x, const float *y, float *out, const size_t &count);
+		static void	_perlin2DBatchSSE2(const float *x, const float *y, float *out, const size_t &count);
+		static void	_perlin2DBatchAVX2(const float *x, const float *y, float *out, const size_t &count);
+
+		// Same for gradient3D
+		static void	_gradient3DBatchScalar(const float *x, const float *y, const float *z, float *out, const size_t &count);
+		static void	_gradient3DBatchSSE2(const float *x, const float *y, const float *z, float *out, const size_t &count);
+		static void	_gradient3DBatchAVX2(const float *x, const float *y, const float *z, float *out, const size_t &count);
+
 	public:
 		static void	setSeed(void *arg);
 		static void	setSeed(const uint64_t &seed);
 
 		static float	perlin2D(const glm::vec2 &v);
 		static float	perlin3D(const glm::vec3 &v);
+
+		// True 3D gradient noise, a lot cheaper than perlin3D which averages six 2D evaluations
+		static float	gradient3D(const glm::vec3 &v);
+
+		// Evaluate perlin2D on "count" points given as separate x and y arrays
+		static void	perlin2DBatch(const float *x, const float *y, float *out, const size_t &count);
+		// Same for perlin3D and gradient3D, typically a whole 32 * 32 * 32 chunk at once
+		static void	perlin3DBatch(const float *x, const float *y, const float *z, float *out, const size_t &count);
+		static void	gradient3DBatch(const float *x, const float *y, const float *z, float *out, const size_t &count);
 };
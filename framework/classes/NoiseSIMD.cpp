@@ -0,0 +1,319 @@
+# include "Noise.hpp"
+# include "CPUDispatch.hpp"
+
+# ifdef CPU_DISPATCH_X86
+#  include <immintrin.h>
+# endif
+
+Noise::Perlin2DBatchFunc	Noise::_perlin2DBatchFunc = SELECT_KERNEL(&_perlin2DBatchScalar, &_perlin2DBatchSSE2, &_perlin2DBatchAVX2);
+Noise::Gradient3DBatchFunc	Noise::_gradient3DBatchFunc = SELECT_KERNEL(&_gradient3DBatchScalar, &_gradient3DBatchSSE2, &_gradient3DBatchAVX2);
+
+# ifdef CPU_DISPATCH_X86
+
+// The kernels follow the exact operation order of perlin2D so the results are bit identical:
+// lattice from a truncating conversion, hash of the 4 corners into the gradient table,
+// dot products as (dx * gx) + (dy * gy), then (b - a) * (3 - w * 2) * w * w + a for both interpolations.
+
+// 32 bits multiplication, SSE2 only has the 32x32 -> 64 bits one
+__attribute__((target("sse2")))
+static inline __m128i	mullo32SSE2(const __m128i &a, const __m128i &b)
+{
+	__m128i	even = _mm_mul_epu32(a, b);
+	__m128i	odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+	return (_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))));
+}
+
+// Same as Noise::_perlin2DHash, returns the gradient table index
+__attribute__((target("sse2")))
+static inline __m128i	hashSSE2(const __m128i &x, const __m128i &y, const __m128i &seed)
+{
+	__m128i	a = _mm_add_epi32(x, seed);
+	__m128i	b = _mm_add_epi32(y, seed);
+
+	a = mullo32SSE2(a, _mm_set1_epi32((int)3284157443u));
+	b = _mm_xor_si128(b, _mm_or_si128(_mm_slli_epi32(a, 16), _mm_srli_epi32(a, 16)));
+	b = mullo32SSE2(b, _mm_set1_epi32(1911520717));
+	a = _mm_xor_si128(a, _mm_or_si128(_mm_slli_epi32(b, 16), _mm_srli_epi32(b, 16)));
+	a = mullo32SSE2(a, _mm_set1_epi32(2048419325));
+
+	return (_mm_srli_epi32(a, 32 - NOISE_GRADIENT_BITS));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i	hashAVX2(const __m256i &x, const __m256i &y, const __m256i &seed)
+{
+	__m256i	a = _mm256_add_epi32(x, seed);
+	__m256i	b = _mm256_add_epi32(y, seed);
+
+	a = _mm256_mullo_epi32(a, _mm256_set1_epi32((int)3284157443u));
+	b = _mm256_xor_si256(b, _mm256_or_si256(_mm256_slli_epi32(a, 16), _mm256_srli_epi32(a, 16)));
+	b = _mm256_mullo_epi32(b, _mm256_set1_epi32(1911520717));
+	a = _mm256_xor_si256(a, _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_srli_epi32(b, 16)));
+	a = _mm256_mullo_epi32(a, _mm256_set1_epi32(2048419325));
+
+	return (_mm256_srli_epi32(a, 32 - NOISE_GRADIENT_BITS));
+}
+
+// Same as Noise::_gradient3DHash, returns the gradient table index
+__attribute__((target("sse2")))
+static inline __m128i	hash3DSSE2(const __m128i &x, const __m128i &y, const __m128i &z, const __m128i &seed)
+{
+	__m128i	a = _mm_add_epi32(x, seed);
+	__m128i	b = _mm_add_epi32(y, seed);
+	__m128i	c = _mm_add_epi32(z, seed);
+
+	a = mullo32SSE2(a, _mm_set1_epi32((int)3284157443u));
+	b = _mm_xor_si128(b, _mm_or_si128(_mm_slli_epi32(a, 16), _mm_srli_epi32(a, 16)));
+	b = mullo32SSE2(b, _mm_set1_epi32(1911520717));
+	c = _mm_xor_si128(c, _mm_or_si128(_mm_slli_epi32(b, 16), _mm_srli_epi32(b, 16)));
+	c = mullo32SSE2(c, _mm_set1_epi32(2048419325));
+	a = _mm_xor_si128(a, _mm_or_si128(_mm_slli_epi32(c, 16), _mm_srli_epi32(c, 16)));
+	a = mullo32SSE2(a, _mm_set1_epi32((int)3284157443u));
+
+	return (_mm_srli_epi32(a, 28));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i	hash3DAVX2(const __m256i &x, const __m256i &y, const __m256i &z, const __m256i &seed)
+{
+	__m256i	a = _mm256_add_epi32(x, seed);
+	__m256i	b = _mm256_add_epi32(y, seed);
+	__m256i	c = _mm256_add_epi32(z, seed);
+
+	a = _mm256_mullo_epi32(a, _mm256_set1_epi32((int)3284157443u));
+	b = _mm256_xor_si256(b, _mm256_or_si256(_mm256_slli_epi32(a, 16), _mm256_srli_epi32(a, 16)));
+	b = _mm256_mullo_epi32(b, _mm256_set1_epi32(1911520717));
+	c = _mm256_xor_si256(c, _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_srli_epi32(b, 16)));
+	c = _mm256_mullo_epi32(c, _mm256_set1_epi32(2048419325));
+	a = _mm256_xor_si256(a, _mm256_or_si256(_mm256_slli_epi32(c, 16), _mm256_srli_epi32(c, 16)));
+	a = _mm256_mullo_epi32(a, _mm256_set1_epi32((int)3284157443u));
+
+	return (_mm256_srli_epi32(a, 28));
+}
+
+// (b - a) * (3 - w * 2) * w * w + a, as Noise::_perlin2DCubInterpol
+__attribute__((target("sse2")))
+static inline __m128	interpolSSE2(const __m128 &a, const __m128 &b, const __m128 &w)
+{
+	__m128	s = _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(w, _mm_set1_ps(2.0f)));
+
+	return (_mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(b, a), s), w), w), a));
+}
+
+__attribute__((target("avx2")))
+static inline __m256	interpolAVX2(const __m256 &a, const __m256 &b, const __m256 &w)
+{
+	__m256	s = _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(w, _mm256_set1_ps(2.0f)));
+
+	return (_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(b, a), s), w), w), a));
+}
+
+__attribute__((target("sse2")))
+void	Noise::_perlin2DBatchSSE2(const float *x, const float *y, float *out, const size_t &count)
+{
+	const __m128i	one = _mm_set1_epi32(1);
+	const __m128i	seed = _mm_set1_epi32(g_randomFactor);
+	const __m128	two = _mm_set1_ps(2.0f);
+	const __m128	three = _mm_set1_ps(3.0f);
+	size_t		i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128	vx = _mm_loadu_ps(x + i);
+		__m128	vy = _mm_loadu_ps(y + i);
+		__m128i	ix[2], iy[2];
+
+		ix[0] = _mm_cvttps_epi32(vx);
+		iy[0] = _mm_cvttps_epi32(vy);
+		ix[1] = _mm_add_epi32(ix[0], one);
+		iy[1] = _mm_add_epi32(iy[0], one);
+
+		const __m128	dx[2] = {_mm_sub_ps(vx, _mm_cvtepi32_ps(ix[0])), _mm_sub_ps(vx, _mm_cvtepi32_ps(ix[1]))};
+		const __m128	dy[2] = {_mm_sub_ps(vy, _mm_cvtepi32_ps(iy[0])), _mm_sub_ps(vy, _mm_cvtepi32_ps(iy[1]))};
+
+		// Dot products of the 4 corners: top left, top right, bottom left, bottom right
+		__m128	d[4];
+
+		for (int c = 0; c < 4; c++) {
+			alignas(16) uint32_t	idx[4];
+			alignas(16) float	gx[4], gy[4];
+
+			_mm_store_si128((__m128i *)idx, hashSSE2(ix[c & 1], iy[c >> 1], seed));
+			for (int l = 0; l < 4; l++) {
+				gx[l] = _gradientsX[idx[l]];
+				gy[l] = _gradientsY[idx[l]];
+			}
+			d[c] = _mm_add_ps(_mm_mul_ps(dx[c & 1], _mm_load_ps(gx)), _mm_mul_ps(dy[c >> 1], _mm_load_ps(gy)));
+		}
+
+		// Weights are the distance to the top left corner
+		__m128	wx = dx[0];
+		__m128	wy = dy[0];
+		__m128	sx = _mm_sub_ps(three, _mm_mul_ps(wx, two));
+		__m128	sy = _mm_sub_ps(three, _mm_mul_ps(wy, two));
+
+		__m128	top = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(d[1], d[0]), sx), wx), wx), d[0]);
+		__m128	bottom = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(d[3], d[2]), sx), wx), wx), d[2]);
+		__m128	res = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(bottom, top), sy), wy), wy), top);
+
+		_mm_storeu_ps(out + i, res);
+	}
+	for (; i < count; i++)
+		out[i] = perlin2D({x[i], y[i]});
+}
+
+__attribute__((target("avx2")))
+void	Noise::_perlin2DBatchAVX2(const float *x, const float *y, float *out, const size_t &count)
+{
+	const __m256i	one = _mm256_set1_epi32(1);
+	const __m256i	seed = _mm256_set1_epi32(g_randomFactor);
+	const __m256	two = _mm256_set1_ps(2.0f);
+	const __m256	three = _mm256_set1_ps(3.0f);
+	size_t		i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256	vx = _mm256_loadu_ps(x + i);
+		__m256	vy = _mm256_loadu_ps(y + i);
+		__m256i	ix[2], iy[2];
+
+		ix[0] = _mm256_cvttps_epi32(vx);
+		iy[0] = _mm256_cvttps_epi32(vy);
+		ix[1] = _mm256_add_epi32(ix[0], one);
+		iy[1] = _mm256_add_epi32(iy[0], one);
+
+		const __m256	dx[2] = {_mm256_sub_ps(vx, _mm256_cvtepi32_ps(ix[0])), _mm256_sub_ps(vx, _mm256_cvtepi32_ps(ix[1]))};
+		const __m256	dy[2] = {_mm256_sub_ps(vy, _mm256_cvtepi32_ps(iy[0])), _mm256_sub_ps(vy, _mm256_cvtepi32_ps(iy[1]))};
+
+		// Dot products of the 4 corners: top left, top right, bottom left, bottom right
+		__m256	d[4];
+
+		for (int c = 0; c < 4; c++) {
+			__m256i	idx = hashAVX2(ix[c & 1], iy[c >> 1], seed);
+			__m256	gx = _mm256_i32gather_ps(_gradientsX, idx, 4);
+			__m256	gy = _mm256_i32gather_ps(_gradientsY, idx, 4);
+
+			d[c] = _mm256_add_ps(_mm256_mul_ps(dx[c & 1], gx), _mm256_mul_ps(dy[c >> 1], gy));
+		}
+
+		// Weights are the distance to the top left corner
+		__m256	wx = dx[0];
+		__m256	wy = dy[0];
+		__m256	sx = _mm256_sub_ps(three, _mm256_mul_ps(wx, two));
+		__m256	sy = _mm256_sub_ps(three, _mm256_mul_ps(wy, two));
+
+		__m256	top = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(d[1], d[0]), sx), wx), wx), d[0]);
+		__m256	bottom = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(d[3], d[2]), sx), wx), wx), d[2]);
+		__m256	res = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(bottom, top), sy), wy), wy), top);
+
+		_mm256_storeu_ps(out + i, res);
+	}
+	for (; i < count; i++)
+		out[i] = perlin2D({x[i], y[i]});
+}
+
+// The gradient3D kernels follow the same rule: floor, hash of the 8 corners,
+// dot products summed as x, y then z, and interpolations along x, then y, then z.
+
+__attribute__((target("sse2")))
+void	Noise::_gradient3DBatchSSE2(const float *x, const float *y, const float *z, float *out, const size_t &count)
+{
+	const __m128i	seed = _mm_set1_epi32(g_randomFactor);
+	const __m128	one = _mm_set1_ps(1.0f);
+	size_t		i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128	v[3] = {_mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i)};
+		__m128i	cell[3][2];
+		__m128	w[3][2];
+
+		// floor() is a truncation minus one for the negative non integer values
+		for (int a = 0; a < 3; a++) {
+			__m128	floored = _mm_cvtepi32_ps(_mm_cvttps_epi32(v[a]));
+
+			floored = _mm_sub_ps(floored, _mm_and_ps(_mm_cmpgt_ps(floored, v[a]), one));
+			cell[a][0] = _mm_cvttps_epi32(floored);
+			cell[a][1] = _mm_add_epi32(cell[a][0], _mm_set1_epi32(1));
+			w[a][0] = _mm_sub_ps(v[a], floored);
+			w[a][1] = _mm_sub_ps(w[a][0], one);
+		}
+
+		__m128	d[8];
+
+		for (int c = 0; c < 8; c++) {
+			const int	cx = c & 1, cy = (c >> 1) & 1, cz = (c >> 2) & 1;
+			alignas(16) uint32_t	idx[4];
+			alignas(16) float	gx[4], gy[4], gz[4];
+
+			_mm_store_si128((__m128i *)idx, hash3DSSE2(cell[0][cx], cell[1][cy], cell[2][cz], seed));
+			for (int l = 0; l < 4; l++) {
+				gx[l] = _gradients3DX[idx[l]];
+				gy[l] = _gradients3DY[idx[l]];
+				gz[l] = _gradients3DZ[idx[l]];
+			}
+			d[c] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0][cx], _mm_load_ps(gx)), _mm_mul_ps(w[1][cy], _mm_load_ps(gy))), _mm_mul_ps(w[2][cz], _mm_load_ps(gz)));
+		}
+
+		__m128	x00 = interpolSSE2(d[0], d[1], w[0][0]);
+		__m128	x10 = interpolSSE2(d[2], d[3], w[0][0]);
+		__m128	x01 = interpolSSE2(d[4], d[5], w[0][0]);
+		__m128	x11 = interpolSSE2(d[6], d[7], w[0][0]);
+
+		__m128	y0 = interpolSSE2(x00, x10, w[1][0]);
+		__m128	y1 = interpolSSE2(x01, x11, w[1][0]);
+
+		_mm_storeu_ps(out + i, interpolSSE2(y0, y1, w[2][0]));
+	}
+	for (; i < count; i++)
+		out[i] = gradient3D({x[i], y[i], z[i]});
+}
+
+__attribute__((target("avx2")))
+void	Noise::_gradient3DBatchAVX2(const float *x, const float *y, const float *z, float *out, const size_t &count)
+{
+	const __m256i	seed = _mm256_set1_epi32(g_randomFactor);
+	const __m256	one = _mm256_set1_ps(1.0f);
+	size_t		i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const __m256	v[3] = {_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i)};
+		__m256i	cell[3][2];
+		__m256	w[3][2];
+
+		for (int a = 0; a < 3; a++) {
+			__m256	floored = _mm256_floor_ps(v[a]);
+
+			cell[a][0] = _mm256_cvttps_epi32(floored);
+			cell[a][1] = _mm256_add_epi32(cell[a][0], _mm256_set1_epi32(1));
+			w[a][0] = _mm256_sub_ps(v[a], floored);
+			w[a][1] = _mm256_sub_ps(w[a][0], one);
+		}
+
+		__m256	d[8];
+
+		for (int c = 0; c < 8; c++) {
+			const int	cx = c & 1, cy = (c >> 1) & 1, cz = (c >> 2) & 1;
+			__m256i	idx = hash3DAVX2(cell[0][cx], cell[1][cy], cell[2][cz], seed);
+
+			// The 16 entries tables fit in two registers, no gather needed
+			__m256	gx = _mm256_blendv_ps(_mm256_permutevar8x32_ps(_mm256_loadu_ps(_gradients3DX), idx), _mm256_permutevar8x32_ps(_mm256_loadu_ps(_gradients3DX + 8), idx), _mm256_castsi256_ps(_mm256_slli_epi32(idx, 28)));
+			__m256	gy = _mm256_blendv_ps(_mm256_permutevar8x32_ps(_mm256_loadu_ps(_gradients3DY), idx), _mm256_permutevar8x32_ps(_mm256_loadu_ps(_gradients3DY + 8), idx), _mm256_castsi256_ps(_mm256_slli_epi32(idx, 28)));
+			__m256	gz = _mm256_blendv_ps(_mm256_permutevar8x32_ps(_mm256_loadu_ps(_gradients3DZ), idx), _mm256_permutevar8x32_ps(_mm256_loadu_ps(_gradients3DZ + 8), idx), _mm256_castsi256_ps(_mm256_slli_epi32(idx, 28)));
+
+			d[c] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w[0][cx], gx), _mm256_mul_ps(w[1][cy], gy)), _mm256_mul_ps(w[2][cz], gz));
+		}
+
+		__m256	x00 = interpolAVX2(d[0], d[1], w[0][0]);
+		__m256	x10 = interpolAVX2(d[2], d[3], w[0][0]);
+		__m256	x01 = interpolAVX2(d[4], d[5], w[0][0]);
+		__m256	x11 = interpolAVX2(d[6], d[7], w[0][0]);
+
+		__m256	y0 = interpolAVX2(x00, x10, w[1][0]);
+		__m256	y1 = interpolAVX2(x01, x11, w[1][0]);
+
+		_mm256_storeu_ps(out + i, interpolAVX2(y0, y1, w[2][0]));
+	}
+	for (; i < count; i++)
+		out[i] = gradient3D({x[i], y[i], z[i]});
+}
+
+# endif
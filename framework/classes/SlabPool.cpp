@@ -0,0 +1,166 @@
+# include <algorithm>
+# include <iostream>
+# include <stdexcept>
+
+# include "SlabPool.hpp"
+
+SlabPool *			SlabPool::_pools[SLAB_POOL_MAX_POOLS] = {};
+std::atomic<size_t>		SlabPool::_poolCount(0);
+thread_local SlabPool::ThreadCaches	SlabPool::_threadCaches;
+
+// Blocks keep the alignment of new, and can hold the free list link
+static size_t	alignBlockSize(const size_t &size)
+{
+	const size_t	alignment = alignof(std::max_align_t);
+	const size_t	blockSize = std::max(size, sizeof(void *));
+
+	return ((blockSize + alignment - 1) / alignment * alignment);
+}
+
+//// SlabPool class
+
+/// Constructors & Destructors
+SlabPool::SlabPool(const std::string &name, const size_t &blockSize)
+	: _name(name), _blockSize(alignBlockSize(blockSize)), _freeBlocks(nullptr), _freeCount(0),
+	_carved(nullptr), _slabEnd(nullptr), _capacity(0), _refills(0), _flushes(0)
+{
+	// Ids are never reused, so a cache left behind by a destroyed pool can not be taken by a new one
+	_id = _poolCount.fetch_add(1);
+	if (_id >= SLAB_POOL_MAX_POOLS)
+		throw std::runtime_error("SlabPool: too many pools, raise SLAB_POOL_MAX_POOLS");
+	_pools[_id] = this;
+}
+
+SlabPool::~SlabPool()
+{
+	_pools[_id] = nullptr;
+	_threadCaches.caches[_id] = ThreadCache();
+	for (char *slab : _slabs)
+		delete [] slab;
+}
+
+// Give the blocks cached by an exiting thread back to their pool
+SlabPool::ThreadCaches::~ThreadCaches()
+{
+	for (size_t id = 0; id < SLAB_POOL_MAX_POOLS; id++)
+		if (_pools[id] && caches[id].count)
+			_pools[id]->_flush(caches[id], caches[id].count);
+}
+/// ---
+
+/// Private Methods
+
+// Move a batch of blocks to the cache, from the freed ones first, then from the slabs
+void	SlabPool::_refill(ThreadCache &cache)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	for (size_t i = 0; i < SLAB_POOL_BATCH; i++) {
+		FreeBlock *	block = _freeBlocks;
+
+		if (block) {
+			_freeBlocks = block->next;
+			_freeCount--;
+		}
+		else {
+			// Carve the blocks one batch at a time, the untouched part of a slab is never paged in
+			if (_carved + _blockSize > _slabEnd) {
+				const size_t	slabBlocks = std::max<size_t>(SLAB_POOL_SLAB_SIZE / _blockSize, 1);
+
+				_slabs.push_back(new char[slabBlocks * _blockSize]);
+				_carved = _slabs.back();
+				_slabEnd = _carved + slabBlocks * _blockSize;
+			}
+			block = (FreeBlock *)_carved;
+			_carved += _blockSize;
+			_capacity++;
+		}
+
+		block->next = cache.head;
+		cache.head = block;
+	}
+	cache.count += SLAB_POOL_BATCH;
+	_refills++;
+}
+
+// Move the first count blocks of the cache back to the pool
+void	SlabPool::_flush(ThreadCache &cache, size_t count)
+{
+	FreeBlock *	first = cache.head;
+	FreeBlock *	last = first;
+
+	for (size_t i = 1; i < count; i++)
+		last = last->next;
+	cache.head = last->next;
+	cache.count -= count;
+
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	last->next = _freeBlocks;
+	_freeBlocks = first;
+	_freeCount += count;
+	_flushes++;
+}
+/// ---
+
+/// Public methods
+void *	SlabPool::allocate()
+{
+	ThreadCache &	cache = _threadCaches.caches[_id];
+
+	if (!cache.head)
+		_refill(cache);
+
+	FreeBlock *	block = cache.head;
+
+	cache.head = block->next;
+	cache.count--;
+	return (block);
+}
+
+void	SlabPool::deallocate(void *ptr)
+{
+	if (!ptr)
+		return ;
+
+	ThreadCache &	cache = _threadCaches.caches[_id];
+	FreeBlock *	block = (FreeBlock *)ptr;
+
+	block->next = cache.head;
+	cache.head = block;
+	// Keep a batch in the cache, so alternating allocations and frees do not go back and forth to the pool
+	if (++cache.count >= SLAB_POOL_BATCH * 2)
+		_flush(cache, SLAB_POOL_BATCH);
+}
+
+const std::string &	SlabPool::getName() const
+{
+	return (_name);
+}
+
+SlabPoolStats	SlabPool::getStats()
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	const size_t	slabBlocks = std::max<size_t>(SLAB_POOL_SLAB_SIZE / _blockSize, 1);
+
+	return ((SlabPoolStats){_blockSize, _slabs.size(), _slabs.size() * slabBlocks * _blockSize, _capacity, _capacity - _freeCount, _refills, _flushes});
+}
+
+void	SlabPool::printStats()
+{
+	for (size_t id = 0; id < std::min<size_t>(_poolCount.load(), SLAB_POOL_MAX_POOLS); id++) {
+		if (!_pools[id])
+			continue;
+
+		SlabPoolStats	stats = _pools[id]->getStats();
+
+		std::cout << "Pool " << _pools[id]->getName() << " (" << stats.blockSize << "B blocks): "
+			<< stats.inUse << "/" << stats.capacity << " blocks in use, " << stats.slabCount << " slabs ("
+			<< stats.reserved / 1024 << "KB), "
+			<< stats.refills << " refills, " << stats.flushes << " flushes" << std::endl;
+	}
+}
+/// ---
+
+//// ---
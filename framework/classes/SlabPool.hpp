@@ -0,0 +1,82 @@
+# pragma once
+
+/// Defines
+# define SLAB_POOL_SLAB_SIZE	65536 // Bytes reserved at once by a pool
+# define SLAB_POOL_BATCH	32 // Blocks moved at once between a thread cache and its pool
+# define SLAB_POOL_MAX_POOLS	16 // Pools alive at once, each thread has a cache for every one
+
+/// System includes
+# include <atomic>
+# include <cstddef>
+# include <cstdint>
+# include <mutex>
+# include <string>
+# include <vector>
+
+typedef struct SlabPoolStats {
+	size_t		blockSize; // in bytes, after alignment
+	size_t		slabCount;
+	size_t		reserved; // Bytes of the slabs
+	size_t		capacity; // Blocks carved out of the slabs so far
+	size_t		inUse; // Blocks given to the threads, including the ones idle in their caches
+	uint64_t	refills; // Batches taken by the thread caches
+	uint64_t	flushes; // Batches given back by the thread caches
+} SlabPoolStats;
+
+// Fixed-size block allocator for the small objects allocated and freed all the time (chunks, layers, ...).
+// Memory is reserved by slabs of SLAB_POOL_SLAB_SIZE bytes and carved into blocks, the freed blocks are reused
+// by the next allocations and the slabs only released with the pool, so a long session does not fragment the heap.
+// Each thread allocates from its own cache without locking, the cache exchanges blocks with the pool by batches.
+// A pool must outlive the threads using it, the caches are given back to their pool when a thread exits.
+class	SlabPool {
+	private:
+		typedef struct FreeBlock {
+			FreeBlock *	next;
+		} FreeBlock;
+
+		typedef struct ThreadCache {
+			FreeBlock *	head = nullptr;
+			size_t		count = 0;
+		} ThreadCache;
+
+		// Caches of the current thread, indexed by pool id
+		typedef struct ThreadCaches {
+			ThreadCache	caches[SLAB_POOL_MAX_POOLS];
+
+			~ThreadCaches();
+		} ThreadCaches;
+
+		const std::string	_name;
+		const size_t		_blockSize;
+		size_t			_id;
+
+		std::mutex		_mutex;
+		std::vector<char *>	_slabs;
+		FreeBlock *		_freeBlocks;
+		size_t			_freeCount;
+		char *			_carved; // Next block never used of the last slab
+		char *			_slabEnd;
+		size_t			_capacity;
+		uint64_t		_refills;
+		uint64_t		_flushes;
+
+		static SlabPool *		_pools[SLAB_POOL_MAX_POOLS];
+		static std::atomic<size_t>	_poolCount;
+		static thread_local ThreadCaches	_threadCaches;
+
+		void	_refill(ThreadCache &cache);
+		void	_flush(ThreadCache &cache, size_t count);
+
+	public:
+		SlabPool(const std::string &name, const size_t &blockSize);
+		~SlabPool();
+
+		void *	allocate();
+		void	deallocate(void *ptr);
+
+		const std::string &	getName() const;
+		SlabPoolStats		getStats();
+
+		// Stats of every pool alive
+		static void	printStats();
+};
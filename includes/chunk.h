@@ -3,4 +3,6 @@
 # include "ChunkHandler.hpp"
 # include "AChunk.hpp"
 # include "ChunkImpl.hpp"
+# include "ChunkLayerStore.hpp"
+# include "ChunkColumn.hpp"
 # include "ChunkMesh.hpp"
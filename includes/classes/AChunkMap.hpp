@@ -0,0 +1,87 @@
+# pragma once
+
+/// Defines
+# define GLM_ENABLE_EXPERIMENTAL
+
+/// System includes
+# include <cstdint>
+# include <cstddef>
+
+/// Dependencies
+# include "glm/glm.hpp"
+# include "chunk.h"
+
+typedef struct ChunkData {
+	ChunkMesh *	mesh = nullptr;
+	AChunk *	chunk = nullptr;
+	glm::ivec3	Wpos = {0, 0, 0};
+	size_t		LOD = 0;
+	bool		neigthbourUpdated = false;
+	bool		inCreation = true;
+	uint32_t	version = 0; // Incremented on each change of the blocks, used to discard outdated meshes
+} ChunkData;
+
+// Non-owning reference to a callable, lets the callbacks go through virtual methods without allocating
+// Only valid during the call it is given to
+template <typename Signature>
+class	ChunkCallback;
+
+template <typename R, typename... Args>
+class	ChunkCallback<R(Args...)> {
+	private:
+		void *	_callable;
+		R	(*_invoke)(void *, Args...);
+
+	public:
+		template <typename F>
+		ChunkCallback(F &fn) : _callable((void *)&fn), _invoke([](void *callable, Args... args) -> R {
+			return (static_cast<R>((*(F *)callable)(args...)));
+		}) {}
+
+		R	operator()(Args... args) const { return (_invoke(_callable, args...)); }
+};
+
+// Interface of the concurrent maps of the loaded chunks (Wpos -> ChunkData).
+// The ChunkData are only reachable through callbacks that run with their entry locked,
+// the callbacks must not access the map again. Entries may move when the map changes, so no reference may be kept.
+class	AChunkMap {
+	protected:
+		typedef ChunkCallback<void(ChunkData &)>			FindCallback;
+		typedef ChunkCallback<bool(ChunkData &, const bool &)>		InsertCallback;
+		typedef ChunkCallback<void(ChunkData *, ChunkData **)>		NeightbourhoodCallback;
+		typedef ChunkCallback<bool(ChunkData &)>			PredicateCallback;
+
+		virtual bool	_find(const glm::ivec3 &pos, const FindCallback &fn) = 0;
+		virtual void	_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn) = 0;
+		virtual void	_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn) = 0;
+		virtual bool	_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred) = 0;
+		virtual void	_forEach(const FindCallback &fn) = 0;
+
+	public:
+		virtual ~AChunkMap() {}
+
+		// Call fn(ChunkData &) on the chunk at pos, return false if it is not in the map
+		template <typename F>
+		bool	find(const glm::ivec3 &pos, F &&fn) { return (_find(pos, FindCallback(fn))); }
+
+		// Call fn(ChunkData &, bool inserted) on the chunk at pos, inserted first if missing
+		// A new entry is removed again if fn returns false
+		template <typename F>
+		void	findOrInsert(const glm::ivec3 &pos, F &&fn) { _findOrInsert(pos, InsertCallback(fn)); }
+
+		// Call fn(ChunkData *chunk, ChunkData *neightbours[6]) with the chunk and its 6 neighbours locked,
+		// nullptr for the missing ones. Neighbours order: -x, +x, -y, +y, -z, +z
+		template <typename F>
+		void	findNeightbourhood(const glm::ivec3 &pos, F &&fn) { _findNeightbourhood(pos, NeightbourhoodCallback(fn)); }
+
+		// Remove the chunk at pos if pred(ChunkData &) is true, return true if it was removed
+		template <typename F>
+		bool	eraseIf(const glm::ivec3 &pos, F &&pred) { return (_eraseIf(pos, PredicateCallback(pred))); }
+
+		// Call fn(ChunkData &) on every chunk, never with the whole map locked
+		template <typename F>
+		void	forEach(F &&fn) { _forEach(FindCallback(fn)); }
+
+		virtual void	clear() = 0;
+		virtual size_t	size() const = 0;
+};
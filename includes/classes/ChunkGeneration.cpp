@@ -2,99 +2,113 @@
 
 /// Private functions
 
-// Chunk Generation thread routine
-void VoxelSystem::_chunkGenerationRoutine() {
-	if (VERBOSE)
-		cout << "> Chunk Generation thread started" << endl;
+// Chunk Generation job, executes one request of the queue
+void VoxelSystem::_chunkGenerationJob() {
+	ChunkRequest	request;
+	RequestTicket	ticket;
 
-	while (!_quitting) {
-
-		// Check if there are chunks to generate, sleep if not
-		if (!_requestedChunks.size() || !_requestedChunksMutex.try_lock()) {
-			this_thread::sleep_for(chrono::milliseconds(THREAD_SLEEP_DURATION));
-			continue;
-		}
-
-		// duplicate requested chunks up to the batch limit
-		deque<ChunkRequest>	localRequestedChunks;
-		size_t			batchCount = 0;
-		
-		for (; batchCount < CHUNK_BATCH_LIMIT / (_cpuCoreCount / CHUNKGEN_CORE_RATIO) && _requestedChunks.size(); batchCount++) {
-			auto	tmp = _requestedChunks.begin();
-
-			if (tmp == _requestedChunks.end())
-				break ;
-
-			ChunkRequest	newReq = *tmp;
-			_requestedChunks.pop_front();
-			localRequestedChunks.push_back(newReq);
-		}
-
-		_requestedChunksMutex.unlock();
+	// Each job is submitted once its request is queued and takes the most urgent one
+	if (!_requestedChunks.pop(request, ticket))
+		return;
 
+	const ivec3 &	pos = request.first;
+	bool		changed = false;
 
-		// Generate/delete chunks that have been duplicated locally
-		ChunkMap 		generatedChunks;
-		deque<ivec3>	chunksToDelete;
+	// Execute the requested action on the chunk, generated outside of the lock
+	// The result is thrown away if the position was requested again in the meantime, the newer request redoes it
+	switch (request.second) {
+		case ChunkAction::CREATE_UPDATE: {
+			bool	loaded = false;
 
-		for (const ChunkRequest &req : localRequestedChunks) {
-			ivec3 pos = req.first;
+			// Already loaded, a DELETE collapsed with this request before being executed
+			_chunks->find(pos, [&loaded](ChunkData &data) { loaded = data.chunk; });
+			if (loaded)
+				break;
 
-			// Execute the requested action on the chunk in local memory
-			switch (req.second) {
-				case ChunkAction::CREATE_UPDATE:
-					generatedChunks[pos] = ChunkData{nullptr, ChunkHandler::createChunk(pos), pos, MAX_LOD};
-					break;
+			AChunk *	chunk = ChunkHandler::createChunk(pos);
 
-				case ChunkAction::DELETE:
-					chunksToDelete.push_back(pos);
-					break;
-			}
+			_chunks->findOrInsert(pos, [&](ChunkData &data, const bool &inserted) {
+				changed = _generateChunk(data, chunk, inserted, ticket);
+				return changed;
+			});
+			break;
 		}
 
+		case ChunkAction::DELETE:
+			_chunks->find(pos, [&](ChunkData &data) {
+				changed = !_requestedChunks.isStale(pos, ticket);
+				if (changed)
+					_deleteChunk(data);
+			});
+			break;
+	}
 
-		vector<ChunkRequest> meshRequests;
-		meshRequests.reserve(batchCount);
-		_chunksMutex.lock();
-
-		// Put the generated chunks in the shared memory and request their meshes
-		for (ChunkMap::value_type &chunk : generatedChunks) {
-			_generateChunk(chunk);
-			meshRequests.push_back({chunk.first, ChunkAction::CREATE_UPDATE});
-		}
-		
-		// Delete the chunks from the shared memory and request the deletion of their meshes
-		for (const ivec3 &pos : chunksToDelete) {
-			_deleteChunk(pos);
-			meshRequests.push_back({pos, ChunkAction::DELETE});
-		}
+	_requestedChunks.release(pos, ticket);
 
-		_chunksMutex.unlock();
+	// Submitted from a worker, the mesh job stays on this worker while the chunk is still in its cache
+	if (changed)
+		requestMesh({{pos, request.second}});
+}
 
-		// Request the mesh generation
-		requestMesh(meshRequests);
+// Recompaction job, compress back the uniform layers of a batch of edited chunks
+// The blocks stay the same, so the meshes are kept
+void VoxelSystem::_recompactionJob(const vector<EditedChunk> &chunks) {
+	RecompactionStats	stats;
+
+	for (const EditedChunk &edited : chunks) {
+		_chunks->find(edited.pos, [&](ChunkData &data) {
+			// Edited again since, or reloaded, a newer entry handles it
+			if (data.chunk && data.version == edited.version)
+				ChunkHandler::recompactChunk(data.chunk, stats);
+		});
 	}
 
-	if (VERBOSE)
-		cout << "Chunk Generation thread stopped" << endl;
+	lock_guard<mutex>	lock(_recompactionMutex);
+
+	_recompactionStats.layers += stats.layers;
+	_recompactionStats.chunks += stats.chunks;
+	_recompactionStats.reclaimed += stats.reclaimed;
 }
 
-// Generate a new chunk
-void VoxelSystem::_generateChunk(ChunkMap::value_type &chunk) {
-	if (_chunks.count(chunk.first))
-		return;
+// Store a generated chunk in its ChunkMap entry, return false if the chunk was thrown away
+// Called with the entry locked. The chunk is dropped if the position has been requested again since
+bool VoxelSystem::_generateChunk(ChunkData &data, AChunk *chunk, const bool &inserted, const RequestTicket &ticket) {
+	// Outdated or already loaded
+	if (_requestedChunks.isStale(data.Wpos, ticket) || data.chunk) {
+		ChunkHandler::releaseChunk(chunk);
+		return false;
+	}
 
-	_chunks[chunk.first] = chunk.second;
+	data.chunk = chunk;
+	data.inCreation = true;
+	if (inserted)
+		data.LOD = MAX_LOD;
+	else
+		data.version++; // The chunk has been unloaded but is still waiting to be erased, its entry is reused
+	return true;
 }
 
 // Delete a chunk
 // It will be removed from the ChunkMap in the main thread
-void VoxelSystem::_deleteChunk(const ivec3 &pos) {
-	if (!_chunks.count(pos))
-		return;
+void VoxelSystem::_deleteChunk(ChunkData &data) {
+	ChunkHandler::releaseChunk(data.chunk);
+	data.chunk = nullptr;
+	data.version++;
+}
+
+// Submit a job for the chunks left untouched for RECOMPACTION_DELAY since their last edit
+// Called from the main thread, a chunk being edited is not decompressed and recompressed at each block
+void VoxelSystem::_scheduleRecompaction() {
+	const chrono::steady_clock::time_point	limit = chrono::steady_clock::now() - chrono::milliseconds(RECOMPACTION_DELAY);
+	vector<EditedChunk>			chunks;
 
-	delete _chunks[pos].chunk;
-	_chunks[pos].chunk = nullptr;
+	while (_editedChunks.size() && _editedChunks.front().time <= limit && chunks.size() < RECOMPACTION_BATCH) {
+		chunks.push_back(_editedChunks.front());
+		_editedChunks.pop_front();
+	}
+
+	if (chunks.size())
+		_jobSystem->submit([this, chunks]() { _recompactionJob(chunks); });
 }
 /// ---
 
@@ -106,17 +120,10 @@ void VoxelSystem::_deleteChunk(const ivec3 &pos) {
 //  - CREATE_UPDATE will generate the chunk and request a mesh creation
 //  - DELETE will delete the chunk and request the deletion of the mesh
 void	VoxelSystem::requestChunk(const vector<ChunkRequest> &requests) {
-	if (!requests.size())
-		return;
-
-	_requestedChunksMutex.lock();
-
-	for (ChunkRequest req : requests) {
-		// Check if the request already exists
-		if (find(_requestedChunks.begin(), _requestedChunks.end(), req) == _requestedChunks.end())
-			_requestedChunks.push_back(req);
-	}
+	// Requests already waiting are collapsed by the queue, one job per queued request
+	size_t	queued = _requestedChunks.push(requests);
 
-	_requestedChunksMutex.unlock();
+	for (size_t i = 0; i < queued; i++)
+		_jobSystem->submit([this]() { _chunkGenerationJob(); });
 }
 /// ---
@@ -0,0 +1,171 @@
+# include <algorithm>
+
+# include "ChunkRequestQueue.hpp"
+
+//// ChunkRequestQueue class
+
+/// Constructors & Destructors
+ChunkRequestQueue::ChunkRequestQueue() : _sequence(0), _lastTicket(0), _size(0), _viewEpoch(0), _heapEpoch(0)
+{
+}
+
+ChunkRequestQueue::~ChunkRequestQueue()
+{
+}
+/// ---
+
+/// Private Methods
+
+// 21 bits per coordinate
+uint64_t	ChunkRequestQueue::_packPosition(const glm::ivec3 &pos)
+{
+	const uint64_t	mask = (1 << 21) - 1;
+
+	return (((uint64_t)pos.x & mask) << 42)
+		| (((uint64_t)pos.y & mask) << 21)
+		| ((uint64_t)pos.z & mask);
+}
+
+// Heap comparator, the top is the lowest priority then the oldest request
+bool	ChunkRequestQueue::_isAfter(const Entry &a, const Entry &b)
+{
+	if (a.priority != b.priority)
+		return (a.priority > b.priority);
+	return (a.sequence > b.sequence);
+}
+
+// Distance to the camera in chunks, scaled up outside of the frustum and more so behind the camera
+float	ChunkRequestQueue::_computePriority(const glm::ivec3 &pos, const ChunkAction &action) const
+{
+	if (action == ChunkAction::DELETE)
+		return (-1.0f);
+
+	const glm::vec3	center = (glm::vec3(pos) + 0.5f) * (float)CHUNK_WIDTH;
+	const glm::vec3	toChunk = center - _view.position;
+	const float	distance = glm::length(toChunk) / CHUNK_WIDTH;
+	const float	radius = CHUNK_WIDTH * 0.87f; // Half of the chunk diagonal
+
+	if (distance < CLOSE_REQUEST_DISTANCE || Camera::isSphereInFrustum(_view.frustum, center, radius))
+		return (distance);
+
+	const float	facing = glm::dot(_view.direction, toChunk) / (distance * CHUNK_WIDTH); // 1 ahead, -1 behind
+
+	return (distance * (1.0f + OUT_OF_VIEW_PRIORITY_FACTOR * (1.0f - facing) * 0.5f));
+}
+
+// Must be called with _mutex locked
+bool	ChunkRequestQueue::_enqueue(const ChunkRequest &request)
+{
+	Slot &	slot = _slots.try_emplace(_packPosition(request.first), Slot{0, request.second, false, 0}).first->second;
+	bool	merged = slot.queued;
+
+	// Same request already waiting, nothing changes
+	if (merged && slot.action == request.second)
+		return (false);
+
+	slot.ticket = ++_lastTicket;
+	slot.action = request.second;
+	slot.queued = true;
+	slot.sequence = _sequence;
+
+	_heap.push_back(Entry{_computePriority(request.first, request.second), _sequence++, request.first, request.second});
+	std::push_heap(_heap.begin(), _heap.end(), _isAfter);
+	return (!merged);
+}
+
+// Re-score every queued request with the current view, O(n)
+// Must be called with _mutex locked
+void	ChunkRequestQueue::_reprioritize()
+{
+	for (Entry &entry : _heap)
+		entry.priority = _computePriority(entry.pos, entry.action);
+	std::make_heap(_heap.begin(), _heap.end(), _isAfter);
+	_heapEpoch = _viewEpoch;
+}
+/// ---
+
+/// Public methods
+bool	ChunkRequestQueue::push(const ChunkRequest &request)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	if (!_enqueue(request))
+		return (false);
+
+	_size.fetch_add(1, std::memory_order_relaxed);
+	return (true);
+}
+
+size_t	ChunkRequestQueue::push(const std::vector<ChunkRequest> &requests)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+	size_t				count = 0;
+
+	for (const ChunkRequest &request : requests)
+		count += _enqueue(request);
+
+	_size.fetch_add(count, std::memory_order_relaxed);
+	return (count);
+}
+
+bool	ChunkRequestQueue::pop(ChunkRequest &request, RequestTicket &ticket)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	if (_heapEpoch != _viewEpoch)
+		_reprioritize();
+
+	while (_heap.size()) {
+		std::pop_heap(_heap.begin(), _heap.end(), _isAfter);
+
+		const Entry	entry = _heap.back();
+		auto		it = _slots.find(_packPosition(entry.pos));
+
+		_heap.pop_back();
+
+		// Replaced by a newer action on the same position, which may already be popped and released
+		if (it == _slots.end() || !it->second.queued || it->second.sequence != entry.sequence)
+			continue;
+
+		it->second.queued = false;
+		request = {entry.pos, entry.action};
+		ticket = it->second.ticket;
+		_size.fetch_sub(1, std::memory_order_relaxed);
+		return (true);
+	}
+	return (false);
+}
+
+bool	ChunkRequestQueue::isStale(const glm::ivec3 &pos, const RequestTicket &ticket)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+	auto				it = _slots.find(_packPosition(pos));
+
+	return (it == _slots.end() || it->second.ticket != ticket);
+}
+
+// The slot is forgotten only if no newer request came in the meantime
+void	ChunkRequestQueue::release(const glm::ivec3 &pos, const RequestTicket &ticket)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+	auto				it = _slots.find(_packPosition(pos));
+
+	if (it != _slots.end() && it->second.ticket == ticket)
+		_slots.erase(it);
+}
+
+void	ChunkRequestQueue::setView(const ViewState &view)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	_view = view;
+	_viewEpoch++;
+}
+
+size_t	ChunkRequestQueue::size() const
+{
+	return (_size.load(std::memory_order_relaxed));
+}
+/// ---
+
+//// ---
@@ -0,0 +1,105 @@
+# pragma once
+
+/// Defines
+# define GLM_ENABLE_EXPERIMENTAL
+# define CLOSE_REQUEST_DISTANCE	2.0f // in chunks, requests this close to the camera are handled as visible
+# define OUT_OF_VIEW_PRIORITY_FACTOR	2.0f // Distance penalty of the requests outside of the frustum, x1 on the sides up to x(1 + factor) behind
+
+/// System includes
+# include <atomic>
+# include <cstdint>
+# include <mutex>
+# include <unordered_map>
+# include <vector>
+
+/// Dependencies
+# include "glm/glm.hpp"
+# include "Camera.hpp"
+# include "AChunk.hpp"
+
+// Interface for chunk & mesh modifications
+enum class ChunkAction {
+	CREATE_UPDATE,
+	DELETE
+};
+typedef std::pair<glm::ivec3, ChunkAction> ChunkRequest; // Wpos, Action
+typedef uint64_t RequestTicket; // Identifies one push, a newer push on the same position makes the older tickets stale
+
+// Camera state the requests are prioritized with
+typedef struct ViewState {
+	glm::vec3	position = {0, 0, 0}; // in blocks
+	glm::vec3	direction = {0, 0, 1}; // normalized
+	Frustum		frustum = {};
+} ViewState;
+
+// Multi-producer multi-consumer priority queue of chunk requests.
+// Deletions are cheap and free memory, they go first in order. Then the closest to the camera,
+// with the ones outside of the frustum pushed back.
+// Changing the view only bumps an epoch, the queued requests are re-scored by the next pop.
+//
+// There is at most one queued request per position: pushing on a position already waiting only replaces its action,
+// so opposite actions collapse into the latest one before a worker sees them.
+// The new action is pushed as a new heap entry, the previous one is skipped once it reaches the top.
+// Every push gets a new ticket. Work started with an older ticket is stale and can be thrown away when it completes,
+// the newer request will redo it. Workers release their ticket once done.
+class	ChunkRequestQueue {
+	friend class ChunkRequestQueueBenchmark; // benchmarks/requestQueue.cpp, checks the slots are released
+
+	private:
+		typedef struct Entry {
+			float		priority; // Lower is sooner
+			uint64_t	sequence;
+			glm::ivec3	pos;
+			ChunkAction	action;
+		} Entry;
+
+		// State of a position, kept from its first push until the holder of its latest ticket releases it
+		typedef struct Slot {
+			RequestTicket	ticket;
+			ChunkAction	action;
+			bool		queued; // Waiting in the heap, false once popped
+			uint64_t	sequence; // Of the heap entry holding the current action
+		} Slot;
+
+		std::vector<Entry>			_heap;
+		std::unordered_map<uint64_t, Slot>	_slots; // Packed position -> Slot
+		std::mutex				_mutex;
+		uint64_t				_sequence;
+		RequestTicket				_lastTicket;
+		std::atomic<size_t>			_size;
+
+		ViewState	_view;
+		uint32_t	_viewEpoch;
+		uint32_t	_heapEpoch; // View epoch the heap is ordered with
+
+		static uint64_t	_packPosition(const glm::ivec3 &pos);
+		static bool	_isAfter(const Entry &a, const Entry &b);
+
+		float	_computePriority(const glm::ivec3 &pos, const ChunkAction &action) const;
+		bool	_enqueue(const ChunkRequest &request);
+		void	_reprioritize();
+
+	public:
+		ChunkRequestQueue();
+		~ChunkRequestQueue();
+
+		// Queue the request, or update the one already waiting on this position
+		// Return true if a new request was queued, false if it was merged
+		bool	push(const ChunkRequest &request);
+		// Return the number of requests actually queued
+		size_t	push(const std::vector<ChunkRequest> &requests);
+
+		// Take the most urgent request, return false if the queue is empty
+		bool	pop(ChunkRequest &request, RequestTicket &ticket);
+
+		// True if the position has been requested again since this ticket was given
+		bool	isStale(const glm::ivec3 &pos, const RequestTicket &ticket);
+		// Must be called once the work of a popped request is done, stale or not
+		void	release(const glm::ivec3 &pos, const RequestTicket &ticket);
+
+		// Update the camera state, the queued requests are re-scored lazily
+		void	setView(const ViewState &view);
+
+		// Approximate while other threads are pushing or popping
+		size_t	size() const;
+};
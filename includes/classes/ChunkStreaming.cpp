@@ -0,0 +1,109 @@
+#include "VoxelSystem.hpp"
+
+static const ivec3	g_loadRadius = {HORIZONTAL_RENDER_DISTANCE, VERTICAL_RENDER_DISTANCE, HORIZONTAL_RENDER_DISTANCE};
+static const ivec3	g_unloadRadius = g_loadRadius + UNLOAD_DISTANCE_MARGIN;
+
+// Append every position of the box around "center" that is not inside the box around "previous"
+// Only the slabs that changed are walked, the overlapping volume is skipped
+static void	boxDifference(vector<ivec3> &out, const ivec3 &center, const ivec3 &previous, const ivec3 &radius) {
+	const ivec3	oldMin = previous - radius;
+	const ivec3	oldMax = previous + radius;
+
+	for (int x = center.x - radius.x; x <= center.x + radius.x; x++) {
+		const bool	xOutside = x < oldMin.x || x > oldMax.x;
+
+		for (int y = center.y - radius.y; y <= center.y + radius.y; y++) {
+			// Whole row outside of the previous box
+			if (xOutside || y < oldMin.y || y > oldMax.y) {
+				for (int z = center.z - radius.z; z <= center.z + radius.z; z++)
+					out.push_back({x, y, z});
+				continue ;
+			}
+
+			// Only the z borders of the row changed
+			for (int z = center.z - radius.z; z <= glm::min(center.z + radius.z, oldMin.z - 1); z++)
+				out.push_back({x, y, z});
+			for (int z = glm::max(center.z - radius.z, oldMax.z + 1); z <= center.z + radius.z; z++)
+				out.push_back({x, y, z});
+		}
+	}
+}
+
+/// Private functions
+
+// Generate every chunk of the render area around the camera, the queue handles the visible ones first
+void	VoxelSystem::_genWorldSpawn() {
+	vector<ChunkRequest>	spawnChunks;
+
+	_cameraChunk = _getCameraChunk();
+	_updateRequestPriorities(true);
+
+	for (int x = -g_loadRadius.x; x <= g_loadRadius.x; x++)
+		for (int y = -g_loadRadius.y; y <= g_loadRadius.y; y++)
+			for (int z = -g_loadRadius.z; z <= g_loadRadius.z; z++)
+				spawnChunks.push_back({_cameraChunk + ivec3{x, y, z}, ChunkAction::CREATE_UPDATE});
+	requestChunk(spawnChunks);
+}
+
+// Return the position of the chunk the camera is in
+ivec3	VoxelSystem::_getCameraChunk() {
+	const vec3	&position = _camera.getCameraInfo().position;
+
+	return ivec3(glm::floor(position / (float)CHUNK_SIZE));
+}
+
+// Give the camera state to the request queues once it entered another chunk or turned enough
+// The queues only re-score their requests on the next pop, so this is cheap
+void	VoxelSystem::_updateRequestPriorities(const bool &force) {
+	const CameraInfo &	info = _camera.getCameraInfo();
+	const vec3		direction = normalize(info.lookAt - info.position);
+	const bool		moved = _getCameraChunk() != ivec3(glm::floor(_viewState.position / (float)CHUNK_SIZE));
+
+	if (!force && !moved && dot(direction, _viewState.direction) > REPRIORITIZE_VIEW_COS)
+		return ;
+
+	_viewState.position = info.position;
+	_viewState.direction = direction;
+	_viewState.frustum = _camera.getFrustum();
+	_requestedChunks.setView(_viewState);
+	_requestedMeshes.setView(_viewState);
+}
+
+// Load the chunks entering the render area and unload the ones leaving the unload area
+// Nothing is done until the camera cross a chunk border
+void	VoxelSystem::_streamChunks() {
+	const ivec3	cameraChunk = _getCameraChunk();
+
+	if (cameraChunk == _cameraChunk)
+		return ;
+
+	vector<ivec3>		enteringChunks;
+	vector<ivec3>		leavingChunks;
+	vector<ChunkRequest>	requests;
+
+	boxDifference(enteringChunks, cameraChunk, _cameraChunk, g_loadRadius);
+	boxDifference(leavingChunks, _cameraChunk, cameraChunk, g_unloadRadius);
+
+	// The queue orders the requests, the unloads first then the visible chunks
+	requests.reserve(enteringChunks.size() + leavingChunks.size());
+	for (const ivec3 &pos : leavingChunks)
+		requests.push_back({pos, ChunkAction::DELETE});
+	for (const ivec3 &pos : enteringChunks)
+		requests.push_back({pos, ChunkAction::CREATE_UPDATE});
+
+	_cameraChunk = cameraChunk;
+	requestChunk(requests);
+}
+/// ---
+
+
+
+/// Public functions
+
+// Per frame update of the voxel system, must be called from the main thread
+void	VoxelSystem::update() {
+	_updateRequestPriorities();
+	_streamChunks();
+	_scheduleRecompaction();
+}
+/// ---
@@ -2,7 +2,50 @@
 # include <ctime>
 
 # include "AChunk.hpp"
+# include "ChunkImpl.hpp"
 
-AChunk::AChunk() {}
+//// AChunk class
+
+/// Constructors & Destructors
+AChunk::AChunk(const ChunkType &type) : _layers(nullptr), _layerMask(0), _type(type), _occupancy(nullptr) {}
 AChunk::~AChunk() {}
+/// ---
+
+/// public methods
+void	AChunk::getLayer(const size_t &y, uint8_t *dst) const
+{
+	this->_layers[y & this->_layerMask]->copyTo(dst);
+}
+
+void	AChunk::getRow(const size_t &x, const size_t &y, uint8_t *dst) const
+{
+	const AChunkLayer *	layer = this->_layers[y & this->_layerMask];
+
+	switch (layer->getType()) {
+		case LayerType::BYTES:
+			memcpy(dst, static_cast<const ChunkLayer *>(layer)->getData() + x * CHUNK_WIDTH, CHUNK_WIDTH);
+			break;
+		case LayerType::SINGLE_BLOCK:
+			memset(dst, (*layer)[0], CHUNK_WIDTH);
+			break;
+		default:
+			for (size_t z = 0; z < CHUNK_WIDTH; z++)
+				dst[z] = static_cast<const PackedChunkLayer *>(layer)->get(x * CHUNK_WIDTH + z);
+			break;
+	}
+}
+
+void	AChunk::getColumn(const size_t &x, const size_t &z, uint8_t *dst) const
+{
+	// A single layer stands for the whole column
+	if (!this->_layerMask) {
+		memset(dst, (*this->_layers[0])[0], CHUNK_HEIGHT);
+		return ;
+	}
+
+	for (size_t y = 0; y < CHUNK_HEIGHT; y++)
+		dst[y] = (*this->_layers[y])[x * CHUNK_WIDTH + z];
+}
+/// ---
 
+//// ---
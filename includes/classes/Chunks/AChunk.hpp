@@ -5,9 +5,11 @@
 # define CHUNK_HEIGHT	32
 # define MAX_WORLD_SIZE	500
 
-# define BLOCK_AT(chunk, x, y, z) (*(*chunk)[y])[x * CHUNK_WIDTH + z]
-# define IS_LAYER_COMPRESSED(chunk, y)	dynamic_cast<SingleBlockChunkLayer *>((*chunk)[y])
-# define IS_CHUNK_COMPRESSED(chunk)	dynamic_cast<SingleBlockChunk *>(chunk)
+# define BLOCK_AT(chunk, x, y, z) (chunk)->getBlock(x, y, z)
+# define IS_LAYER_COMPRESSED(chunk, y)	((*chunk)[y]->getType() == LayerType::SINGLE_BLOCK)
+# define IS_CHUNK_COMPRESSED(chunk)	((chunk)->getType() == ChunkType::SINGLE_BLOCK)
+# define OCCUPANCY_SIZE	(CHUNK_WIDTH * CHUNK_WIDTH) // Columns of the occupancy mask of a chunk
+# define OCCUPANCY_SOLID	((uint32_t)((1ull << CHUNK_WIDTH) - 1)) // Occupancy column full of blocks
 
 /// System includes
 # include <cstdlib>
@@ -19,19 +21,51 @@
 
 /// Global variables
 
+static_assert(CHUNK_WIDTH == 32 && CHUNK_HEIGHT == 32, "an occupancy column is a uint32_t, transposed as a 32 x 32 bit matrix");
+
+// Tag of the concrete chunk type, checked instead of a dynamic_cast
+enum class ChunkType : uint8_t {
+	LAYERED,
+	SINGLE_BLOCK
+};
+
+// The block accessors are not virtual: every chunk type exposes its layers through _layers,
+// a SingleBlockChunk maps every height to its only layer with a mask of 0.
 class	AChunk {
 	protected:
 		// holds uint for but will be replaced by Block class
 		std::vector<uint8_t>	_blockPalette;
 
+		class AChunkLayer **	_layers;
+		size_t			_layerMask; // CHUNK_HEIGHT - 1, or 0 when a single layer stands for the whole chunk
+		ChunkType		_type;
+		uint32_t *		_occupancy; // OCCUPANCY_SIZE columns
+
 	public:
-		AChunk();
-		AChunk(const uint8_t &id) { (void)id; }
+		AChunk(const ChunkType &type);
+
+		class AChunkLayer *	& operator[](const size_t &i) { return (this->_layers[i & this->_layerMask]); }
+		ChunkType		getType() const { return (this->_type); }
+
+		// Inlined in ChunkImpl.hpp, once the layers are defined
+		uint8_t	getBlock(const size_t &x, const size_t &y, const size_t &z) const;
+
+		// Occupancy along z, bit z of [y * CHUNK_WIDTH + x] is set for a non-air block. Kept up to date by generate and setBlock,
+		// the columns along x and y are the same bits transposed (BitMatrix::transpose32)
+		const uint32_t *	getOccupancy() const { return (this->_occupancy); }
+		bool			isSolid(const size_t &x, const size_t &y, const size_t &z) const {
+			return ((this->_occupancy[y * CHUNK_WIDTH + x] >> z) & 1);
+		}
 
-		virtual class AChunkLayer *	& operator[](const size_t &i) = 0;
+		// Bulk copies, same layout as the layers ([x * CHUNK_WIDTH + z])
+		void	getLayer(const size_t &y, uint8_t *dst) const; // CHUNK_WIDTH * CHUNK_WIDTH blocks
+		void	getRow(const size_t &x, const size_t &y, uint8_t *dst) const; // CHUNK_WIDTH blocks along z
+		void	getColumn(const size_t &x, const size_t &z, uint8_t *dst) const; // CHUNK_HEIGHT blocks along y
 
 		virtual	~AChunk() = 0;
 		virtual void	print() = 0;
 		virtual void	generate(const glm::ivec3 &pos) = 0;
 		virtual void	setBlock(const glm::ivec3 &pos, const uint8_t &blockID) = 0;
+		// Bytes held by the chunk and its layers
+		virtual size_t	getMemoryUsage() const = 0;
 };
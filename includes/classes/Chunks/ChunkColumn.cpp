@@ -0,0 +1,194 @@
+/// class idependant system includes
+# include <algorithm>
+# include <cmath>
+
+# include "ChunkColumn.hpp"
+# include "Noise.hpp"
+
+std::unordered_map<glm::ivec2, ChunkColumnCache::Entry>	ChunkColumnCache::_columns;
+std::list<glm::ivec2>	ChunkColumnCache::_lru;
+std::mutex		ChunkColumnCache::_mutex;
+
+//// ChunkColumn class
+
+/// Constructors & Destructors
+ChunkColumn::ChunkColumn() : minHeight(0), maxHeight(0) {}
+ChunkColumn::~ChunkColumn() {}
+/// ---
+
+/// Private Methods
+
+void	ChunkColumn::_computeHeatMap(const glm::ivec3 &pos)
+{
+	float	x[CHUNK_WIDTH * CHUNK_WIDTH];
+	float	y[CHUNK_WIDTH * CHUNK_WIDTH];
+	float	noise[CHUNK_WIDTH * CHUNK_WIDTH];
+	float	amp = 64.0f;
+
+	std::fill_n(this->heatMap, CHUNK_WIDTH * CHUNK_WIDTH, 0.0f);
+
+	for (int j = 0; j < 8; j++) {
+		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+			x[i] = (2048.0f + pos.x + (i % CHUNK_WIDTH)) / (amp * 32.0f);
+			y[i] = (2048.0f + pos.z+ ((float)i / CHUNK_WIDTH)) / (amp * 32.0f);
+		}
+		Noise::perlin2DBatch(x, y, noise, CHUNK_WIDTH * CHUNK_WIDTH);
+
+		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+			this->heatMap[i] += noise[i] * amp;
+		amp -= amp / 2.0f;
+	}
+}
+
+void	ChunkColumn::_computeHumidityMap(const glm::ivec3 &pos)
+{
+	float	x[CHUNK_WIDTH * CHUNK_WIDTH];
+	float	y[CHUNK_WIDTH * CHUNK_WIDTH];
+	float	noise[CHUNK_WIDTH * CHUNK_WIDTH];
+	float	amp = 64.0f;
+
+	std::fill_n(this->humidityMap, CHUNK_WIDTH * CHUNK_WIDTH, 0.0f);
+
+	for (int j = 0; j < 8; j++) {
+		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+			x[i] = (1024.0f + pos.x + (i % CHUNK_WIDTH)) / (amp * 32.0f);
+			y[i] = (1024.0f + pos.z+ ((float)i / CHUNK_WIDTH)) / (amp * 32.0f);
+		}
+		Noise::perlin2DBatch(x, y, noise, CHUNK_WIDTH * CHUNK_WIDTH);
+
+		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+			this->humidityMap[i] += noise[i] * amp;
+		amp -= amp / 2.0f;
+	}
+}
+
+void	ChunkColumn::_computeFeatureMap(const glm::ivec3 &pos)
+{
+	float		x[CHUNK_WIDTH * CHUNK_WIDTH];
+	float		y[CHUNK_WIDTH * CHUNK_WIDTH];
+	uint32_t	maxPos = MAX_WORLD_SIZE * CHUNK_WIDTH;
+
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+		x[i] = (maxPos + pos.x + (i % CHUNK_WIDTH)) / 2.0f;
+		y[i] = (maxPos + pos.z+ ((float)i / CHUNK_WIDTH)) / 2.0f;
+	}
+	Noise::perlin2DBatch(x, y, this->featuresMap, CHUNK_WIDTH * CHUNK_WIDTH);
+
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+		this->featuresMap[i] = pow(this->featuresMap[i] * 2.0f, 16.0f);
+}
+
+void	ChunkColumn::_computeHeightMap(const glm::ivec3 &pos)
+{
+	float		x[CHUNK_WIDTH * CHUNK_WIDTH];
+	float		y[CHUNK_WIDTH * CHUNK_WIDTH];
+	float		noise[CHUNK_WIDTH * CHUNK_WIDTH];
+	float *		factors = this->heightMap;
+	uint32_t	maxPos = MAX_WORLD_SIZE * CHUNK_WIDTH;
+	float		amp = 128;
+
+	std::fill_n(factors, CHUNK_WIDTH * CHUNK_WIDTH, 0.0f);
+
+	// Pre-compute the perlin noise factors, one octave at a time
+	for (int j = 0; j < 10; j++) {
+		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+			x[i] = (pos.x + maxPos + (i % CHUNK_WIDTH)) / (amp * 3);
+			y[i] = (pos.z + maxPos + ((float)i / CHUNK_WIDTH)) / (amp * 3);
+		}
+		Noise::perlin2DBatch(x, y, noise, CHUNK_WIDTH * CHUNK_WIDTH);
+
+		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+			float	factor = factors[i] + noise[i] * (amp / 2);
+
+			if (factor > 0)
+				factor = pow(factor, 1.03);
+			else
+				factor = -pow(fabsf(factor), 1.04);
+			factors[i] = factor;
+		}
+		amp -= amp / 2;
+	}
+
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+		x[i] = (pos.x + (i % CHUNK_WIDTH)) / 2048;
+		y[i] = (pos.z+ ((float)i / CHUNK_WIDTH)) / 2048;
+	}
+	Noise::perlin2DBatch(x, y, noise, CHUNK_WIDTH * CHUNK_WIDTH);
+
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+		float	factor = factors[i];
+
+		if (factor > 0)
+			factor = pow(factor, 1.1);
+		else
+			factor = factor * 0.2;
+
+		factors[i] = factor + noise[i] * 512;
+	}
+}
+
+/// ---
+
+/// Public methods
+void	ChunkColumn::compute(const glm::ivec2 &columnPos)
+{
+	std::call_once(this->_computed, [this, &columnPos]() {
+		glm::ivec3	pos = {columnPos.x * CHUNK_WIDTH, 0, columnPos.y * CHUNK_WIDTH};
+
+		_computeHeightMap(pos);
+		minHeight = *std::min_element(heightMap, heightMap + CHUNK_WIDTH * CHUNK_WIDTH);
+		maxHeight = *std::max_element(heightMap, heightMap + CHUNK_WIDTH * CHUNK_WIDTH);
+		_computeHeatMap(pos);
+		_computeHumidityMap(pos);
+		_computeFeatureMap(pos);
+	});
+}
+/// ---
+
+//// ---
+
+//// ChunkColumnCache class
+
+/// Public methods
+ChunkColumnPtr	ChunkColumnCache::get(const glm::ivec2 &columnPos)
+{
+	ChunkColumnPtr	column;
+
+	_mutex.lock();
+
+	auto	it = _columns.find(columnPos);
+
+	if (it != _columns.end()) {
+		// Move the column to the front of the LRU list
+		_lru.splice(_lru.begin(), _lru, it->second.second);
+		column = it->second.first;
+	}
+	else {
+		// Evict the least recently used column if the cache is full
+		if (_columns.size() >= COLUMN_CACHE_SIZE) {
+			_columns.erase(_lru.back());
+			_lru.pop_back();
+		}
+
+		column = std::make_shared<ChunkColumn>();
+		_lru.push_front(columnPos);
+		_columns[columnPos] = Entry(column, _lru.begin());
+	}
+
+	_mutex.unlock();
+
+	// Computed outside of the lock so other columns can be fetched meanwhile
+	column->compute(columnPos);
+	return (column);
+}
+
+void	ChunkColumnCache::clear()
+{
+	_mutex.lock();
+	_columns.clear();
+	_lru.clear();
+	_mutex.unlock();
+}
+/// ---
+
+//// ---
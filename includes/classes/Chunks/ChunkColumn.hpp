@@ -0,0 +1,60 @@
+# pragma once
+
+/// Defines
+# define GLM_ENABLE_EXPERIMENTAL
+# define COLUMN_CACHE_SIZE	1024 // in columns, each column holds 16KB of noise maps
+
+/// System includes
+# include <list>
+# include <memory>
+# include <mutex>
+# include <unordered_map>
+
+/// Dependencies
+# include "glm/gtx/hash.hpp"
+# include "AChunk.hpp"
+
+// 2D noise maps of a chunk column.
+// They only depend on the x/z position, so every chunk stacked in the column share them.
+class	ChunkColumn {
+	private:
+		std::once_flag	_computed;
+
+		void	_computeHeatMap(const glm::ivec3 &pos);
+		void	_computeHeightMap(const glm::ivec3 &pos);
+		void	_computeHumidityMap(const glm::ivec3 &pos);
+		void	_computeFeatureMap(const glm::ivec3 &pos);
+
+	public:
+		float	heightMap[CHUNK_WIDTH * CHUNK_WIDTH];
+		float	heatMap[CHUNK_WIDTH * CHUNK_WIDTH];
+		float	humidityMap[CHUNK_WIDTH * CHUNK_WIDTH];
+		float	featuresMap[CHUNK_WIDTH * CHUNK_WIDTH];
+		float	minHeight; // Bounds of the height map
+		float	maxHeight;
+
+		ChunkColumn();
+		~ChunkColumn();
+
+		// Compute the noise maps, only the first call does the work.
+		// Concurrent callers wait for it to finish.
+		void	compute(const glm::ivec2 &columnPos);
+};
+
+typedef std::shared_ptr<ChunkColumn>	ChunkColumnPtr;
+
+// LRU bounded cache of chunk columns, shared by the generation threads.
+// A column evicted while still in use is kept alive by its shared pointer.
+class	ChunkColumnCache {
+	private:
+		typedef std::pair<ChunkColumnPtr, std::list<glm::ivec2>::iterator>	Entry;
+
+		static std::unordered_map<glm::ivec2, Entry>	_columns;
+		static std::list<glm::ivec2>	_lru; // Most recently used first
+		static std::mutex	_mutex;
+
+	public:
+		// Return the computed column at columnPos (chunk coordinates)
+		static ChunkColumnPtr	get(const glm::ivec2 &columnPos);
+		static void		clear();
+};
@@ -13,26 +13,58 @@ AChunk	* ChunkHandler::createChunk(const glm::ivec3 &chunkPos)
 		chunkPos.z * CHUNK_WIDTH,
 	};
 
-	AChunk	* chunk = new LayeredChunk(1);
-	chunk->generate(wordPos);
-	
-	size_t	count = 0;
+	uint8_t	id = 0;
 
-	for (int i = 0; i < CHUNK_HEIGHT; i++)
-		if (IS_LAYER_COMPRESSED(chunk, i))
-			count++;
+	// Cave lattice evaluated by isUniform for the deep chunks, generate does not evaluate it again.
+	// Reused by every chunk created on the thread.
+	static thread_local CaveLattice	lattice;
+
+	lattice.cells = -1;
+
+	// Trivially empty or solid chunks skip the generation entirely
+	if (LayeredChunk::isUniform(wordPos, id, lattice))
+		return (SingleBlockChunk::acquire(id));
+
+	AChunk	* chunk = new LayeredChunk(1);
+	static_cast<LayeredChunk *>(chunk)->generate(wordPos, lattice);
 
-	if (count == CHUNK_HEIGHT)
+	if (_isUniform(chunk))
 		chunk = _chunkToBlock(chunk);
 	return (chunk);
 }
 
-void	ChunkHandler::setBlock(AChunk *chunk, const glm::ivec3 &pos, const uint8_t &blockID)
+void	ChunkHandler::releaseChunk(AChunk *chunk)
+{
+	if (!chunk)
+		return ;
+	if (IS_CHUNK_COMPRESSED(chunk))
+		static_cast<SingleBlockChunk *>(chunk)->release();
+	else
+		delete chunk;
+}
+
+// A SingleBlockChunk is shared, it is copied to a LayeredChunk of its own before the edit
+void	ChunkHandler::setBlock(AChunk *&chunk, const glm::ivec3 &pos, const uint8_t &blockID)
 {
 	if (IS_CHUNK_COMPRESSED(chunk))
 		chunk = _blockToChunk(chunk);
 	chunk->setBlock(pos, blockID);
 }
+
+void	ChunkHandler::recompactChunk(AChunk *&chunk, RecompactionStats &stats)
+{
+	if (IS_CHUNK_COMPRESSED(chunk))
+		return ;
+
+	const size_t	usage = chunk->getMemoryUsage();
+
+	stats.layers += static_cast<LayeredChunk *>(chunk)->recompact();
+	if (_isUniform(chunk)) {
+		chunk = _chunkToBlock(chunk);
+		stats.chunks++;
+	}
+	stats.reclaimed += usage - chunk->getMemoryUsage();
+}
 /// ---
 
 /// private methods
@@ -42,17 +74,26 @@ AChunk	* ChunkHandler::_chunkToBlock(AChunk *chunk)
 
 	delete chunk;
 
-	return (new SingleBlockChunk(id));
+	return (SingleBlockChunk::acquire(id));
 }
 
 AChunk	* ChunkHandler::_blockToChunk(AChunk *chunk)
 {
 	uint8_t	id = BLOCK_AT(chunk, 0, 0, 0);
 
-	delete chunk;
+	releaseChunk(chunk);
 
 	return (new LayeredChunk(id));
 }
+
+// Every layer compressed with the same block
+bool	ChunkHandler::_isUniform(AChunk *chunk)
+{
+	for (int i = 0; i < CHUNK_HEIGHT; i++)
+		if (!IS_LAYER_COMPRESSED(chunk, i) || (*(*chunk)[i])[0] != BLOCK_AT(chunk, 0, 0, 0))
+			return (false);
+	return (true);
+}
 /// ---
 
 //// ---
@@ -12,12 +12,24 @@
 
 /// Global variables
 
+typedef struct RecompactionStats {
+	size_t	layers = 0; // Layers compressed back to a single block
+	size_t	chunks = 0; // Chunks compressed back to a single block
+	size_t	reclaimed = 0; // in bytes
+} RecompactionStats;
+
 class	ChunkHandler {
 	private:
 		static class AChunk	* _chunkToBlock(class AChunk *chunk);
 		static class AChunk	* _blockToChunk(class AChunk *chunk);
+		static bool		_isUniform(class AChunk *chunk);
 
 	public:
 		static class AChunk	* createChunk(const glm::ivec3 &chunkPos);
-		static void		setBlock(AChunk *chunk, const glm::ivec3 &pos, const uint8_t &blockID);
+		// Free a chunk, a shared SingleBlockChunk is only given back. Never delete a chunk directly
+		static void		releaseChunk(AChunk *chunk);
+		// The chunk is replaced if it has to be decompressed
+		static void		setBlock(AChunk *&chunk, const glm::ivec3 &pos, const uint8_t &blockID);
+		// Compress back the layers and the chunk made uniform by the edits, the chunk is replaced if it is collapsed
+		static void		recompactChunk(AChunk *&chunk, RecompactionStats &stats);
 };
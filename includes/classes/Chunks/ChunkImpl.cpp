@@ -1,158 +1,273 @@
 /// class idependant system includes
+# include <algorithm>
 # include <iostream>
 # include <mutex>
+# include <vector>
 
 # include "ChunkImpl.hpp"
+# include "CPUDispatch.hpp"
 # include "Noise.hpp"
 # include "features_declaration.h"
 
-std::list<std::pair<glm::ivec3, WorldFeature> >	g_pendingFeatures;
+# ifdef CPU_DISPATCH_X86
+#  include <immintrin.h>
+# endif
+
+std::unordered_map<glm::ivec3, std::list<WorldFeature> >	g_pendingFeatures;
 
 std::mutex	g_pendingFeaturesMutex;
 
 extern bool	NO_CAVES;
+extern bool	GRADIENT_CAVES;
+extern bool	FULL_CAVES;
+extern bool	PACKED_LAYERS;
+extern bool	INTERN_LAYERS;
+
+SlabPool	LayeredChunk::_pool("LayeredChunk", sizeof(LayeredChunk));
+SlabPool	LayeredChunk::_layersPool("LayeredChunk layers", sizeof(AChunkLayer *) * CHUNK_HEIGHT);
+SlabPool	SingleBlockChunkLayer::_pool("SingleBlockChunkLayer", sizeof(SingleBlockChunkLayer));
+SlabPool	ChunkLayer::_pool("ChunkLayer", sizeof(ChunkLayer));
+SlabPool	ChunkLayer::_dataPool("ChunkLayer blocks", CHUNK_WIDTH * CHUNK_WIDTH);
+SlabPool	PackedChunkLayer::_pool("PackedChunkLayer", sizeof(PackedChunkLayer));
+SlabPool	PackedChunkLayer::_bitsPools[4] = {
+	{"PackedChunkLayer indices (1 bit)", CHUNK_WIDTH * CHUNK_WIDTH / 8},
+	{"PackedChunkLayer indices (2 bits)", CHUNK_WIDTH * CHUNK_WIDTH * 2 / 8},
+	{"PackedChunkLayer indices (4 bits)", CHUNK_WIDTH * CHUNK_WIDTH * 4 / 8},
+	{"PackedChunkLayer indices (8 bits)", CHUNK_WIDTH * CHUNK_WIDTH}
+};
+
+// After the pools, so it is destroyed before them
+SingleBlockChunk::Instances	SingleBlockChunk::_instances;
+uint32_t			SingleBlockChunk::_solidOccupancy[OCCUPANCY_SIZE];
+uint32_t			SingleBlockChunk::_emptyOccupancy[OCCUPANCY_SIZE];
+
+// Uniformity check of a layer, the CHUNK_WIDTH * CHUNK_WIDTH blocks are compared to the first one.
+// The differences are accumulated over 4 words or vectors before testing them,
+// so a uniform layer costs few branches and a generated one, which usually differs early, stops quickly.
+typedef bool	(*UniformLayerFunc)(const uint8_t *blocks);
+
+static bool	isUniformLayerScalar(const uint8_t *blocks)
+{
+	const uint64_t	pattern = blocks[0] * 0x0101010101010101ull;
+
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i += 4 * sizeof(uint64_t)) {
+		uint64_t	diff = 0;
+
+		for (size_t j = 0; j < 4 * sizeof(uint64_t); j += sizeof(uint64_t)) {
+			uint64_t	word;
+
+			memcpy(&word, blocks + i + j, sizeof(uint64_t));
+			diff |= word ^ pattern;
+		}
+		if (diff)
+			return (false);
+	}
+	return (true);
+}
+
+# ifdef CPU_DISPATCH_X86
+__attribute__((target("sse2")))
+static bool	isUniformLayerSSE2(const uint8_t *blocks)
+{
+	const __m128i	pattern = _mm_set1_epi8(blocks[0]);
+
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i += 4 * sizeof(__m128i)) {
+		__m128i	diff = _mm_setzero_si128();
+
+		for (size_t j = 0; j < 4 * sizeof(__m128i); j += sizeof(__m128i))
+			diff = _mm_or_si128(diff, _mm_xor_si128(_mm_loadu_si128((const __m128i *)(blocks + i + j)), pattern));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF)
+			return (false);
+	}
+	return (true);
+}
+
+__attribute__((target("avx2")))
+static bool	isUniformLayerAVX2(const uint8_t *blocks)
+{
+	const __m256i	pattern = _mm256_set1_epi8(blocks[0]);
+
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i += 4 * sizeof(__m256i)) {
+		__m256i	diff = _mm256_setzero_si256();
+
+		for (size_t j = 0; j < 4 * sizeof(__m256i); j += sizeof(__m256i))
+			diff = _mm256_or_si256(diff, _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(blocks + i + j)), pattern));
+		if (!_mm256_testz_si256(diff, diff))
+			return (false);
+	}
+	return (true);
+}
+# endif
+
+static const UniformLayerFunc	isUniformLayer = SELECT_KERNEL(&isUniformLayerScalar, &isUniformLayerSSE2, &isUniformLayerAVX2);
+
+// Bit z set for each non-air block of the CHUNK_WIDTH blocks, 8 at a time:
+// the high bit of each non-zero byte is set, then the 8 high bits are gathered in the top byte by the multiplication
+static uint32_t	solidBits(const uint8_t *blocks)
+{
+	uint32_t	bits = 0;
+
+	for (size_t z = 0; z < CHUNK_WIDTH; z += sizeof(uint64_t)) {
+		uint64_t	word;
+
+		memcpy(&word, blocks + z, sizeof(uint64_t));
+		word = (((word & 0x7F7F7F7F7F7F7F7Full) + 0x7F7F7F7F7F7F7F7Full) | word) & 0x8080808080808080ull;
+		bits |= (uint32_t)(((word >> 7) * 0x0102040810204080ull) >> 56) << z;
+	}
+	return (bits);
+}
 
 //// LayeredChunk class
 
 /// Constructors & Destructors
-LayeredChunk::LayeredChunk(const uint8_t &id)
+LayeredChunk::LayeredChunk(const uint8_t &id) : AChunk(ChunkType::LAYERED)
 {
 	// Chunk Layer allocation
-	this->_layer = new AChunkLayer*[CHUNK_HEIGHT];
+	this->_layers = (AChunkLayer **)_layersPool.allocate();
+	this->_layerMask = CHUNK_HEIGHT - 1;
 	for (int i = 0; i < CHUNK_HEIGHT; i++)
-		this->_layer[i] = new SingleBlockChunkLayer(id);
+		this->_layers[i] = new SingleBlockChunkLayer(id);
+
+	this->_occupancy = this->_masks;
+	std::fill(this->_masks, this->_masks + OCCUPANCY_SIZE, id ? OCCUPANCY_SOLID : 0);
 }
 
 LayeredChunk::~LayeredChunk()
 {
 	for (int i = 0; i < CHUNK_HEIGHT; i++)
-		delete this->_layer[i];
-	delete [] this->_layer;
+		delete this->_layers[i];
+	_layersPool.deallocate(this->_layers);
+}
+
+void *	LayeredChunk::operator new(size_t size)
+{
+	(void)size;
+	return (_pool.allocate());
 }
-/// ---
 
-/// Operator Overloads
-AChunkLayer *	& LayeredChunk::operator[](const size_t &i)
+void	LayeredChunk::operator delete(void *ptr)
 {
-	return (this->_layer[i]);
+	_pool.deallocate(ptr);
 }
 /// ---
 
 /// Private Methods
 
-float *	LayeredChunk::_computeHeatMap(const glm::ivec3 &pos)
+// Evaluate the cave noise on the lattice of the chunk, every CAVE_LATTICE_STEP blocks, or every block with FULL_CAVES.
+// Points are stored as [(lx * size + lz) * (cells + 1) + ly] with size = CHUNK_WIDTH / step + 1.
+// lattice.cells is set to the number of lattice cells along y with at least one block under the surface,
+// the layers above them are not evaluated.
+void	LayeredChunk::_computeCaveLattice(CaveLattice &lattice, const glm::ivec3 &pos, const ChunkColumn &column)
 {
-	float *	factors = new float[CHUNK_WIDTH * CHUNK_WIDTH];
-	
-	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
-		float	factor = 0;
-		float	amp = 64.0f;
-	
-		for (int j = 0; j < 8; j++) {	
-			factor += Noise::perlin2D(glm::vec2{(2048.0f + pos.x + (i % CHUNK_WIDTH)) / (amp * 32.0f),
-					(2048.0f + pos.z+ ((float)i / CHUNK_WIDTH)) / (amp * 32.0f)}) * amp;
-			amp -= amp / 2.0f;
+	const int	step = (FULL_CAVES) ? 1 : CAVE_LATTICE_STEP;
+	const int	size = CHUNK_WIDTH / step + 1; // Lattice points per axis
+	uint32_t	maxPos = MAX_WORLD_SIZE * CHUNK_WIDTH;
+	int &		cells = lattice.cells;
+
+	cells = 0;
+	while (cells < CHUNK_HEIGHT / step && pos.y + cells * step < column.maxHeight)
+		cells++;
+	if (!cells)
+		return ;
+
+	const int	layers = cells + 1;
+	const size_t	count = size * size * layers;
+
+	// Reused by every lattice of the worker, it only grows
+	static thread_local std::vector<float>	scratch;
+
+	scratch.resize(count * 7);
+
+	float	*x = scratch.data(), *y = x + count, *z = y + count, *octave = z + count;
+	float	*sx = octave + count, *sy = sx + count, *sz = sy + count;
+
+	for (int lx = 0; lx < size; lx++) {
+		for (int lz = 0; lz < size; lz++) {
+			for (int ly = 0; ly < layers; ly++) {
+				size_t	i = (lx * size + lz) * layers + ly;
+
+				x[i] = maxPos + pos.x + lx * step;
+				y[i] = maxPos + pos.y + ly * step;
+				z[i] = maxPos + pos.z + lz * step;
+			}
 		}
-		factors[i] = factor;
 	}
-	return (factors);
-}
 
-float *	LayeredChunk::_computeHumidityMap(const glm::ivec3 &pos)
-{
-	float *	factors = new float[CHUNK_WIDTH * CHUNK_WIDTH];
+	void	(*noise3D)(const float *, const float *, const float *, float *, const size_t &) = (GRADIENT_CAVES) ? &Noise::gradient3DBatch : &Noise::perlin3DBatch;
+	float	*points;
+	float	amp = 20.0f;
 
-	for (int i = 0; i < pow(CHUNK_WIDTH, 2); i++) {
-		float	factor = 0;
-		float	amp = 64.0f;
-	
-		for (int j = 0; j < 8; j++) {	
-			factor += Noise::perlin2D(glm::vec2{(1024.0f + pos.x + (i % CHUNK_WIDTH)) / (amp * 32.0f),
-					(1024.0f + pos.z+ ((float)i / CHUNK_WIDTH)) / (amp * 32.0f)}) * amp;
-			amp -= amp / 2.0f;
-		}
-		factors[i] = factor;
+	lattice.points.resize(count);
+	points = lattice.points.data();
+	for (size_t i = 0; i < count; i++) {
+		sx[i] = x[i] / amp;
+		sy[i] = y[i] / amp;
+		sz[i] = z[i] / amp;
+	}
+	noise3D(sx, sy, sz, octave, count);
+	for (size_t i = 0; i < count; i++)
+		points[i] = octave[i] * amp;
+
+	amp = 120;
+	for (size_t i = 0; i < count; i++) {
+		sx[i] = x[i] / amp;
+		sy[i] = y[i] / amp;
+		sz[i] = z[i] / amp;
 	}
-	return (factors);
+	noise3D(sx, sy, sz, octave, count);
+	for (size_t i = 0; i < count; i++)
+		points[i] -= fabsf(octave[i] * amp);
 }
 
-float *	LayeredChunk::_computeFeatureMap(const glm::ivec3 &pos)
+// Fill "factors" with the cave noise of the chunk, indexed as [(x * CHUNK_WIDTH + z) * CHUNK_HEIGHT + y].
+// The lattice is trilinearly interpolated in between its points (a no-op with FULL_CAVES), the skipped cells are left at 0.
+// It is only evaluated if isUniform did not already.
+void	LayeredChunk::_computeCaveNoise(float *factors, const glm::ivec3 &pos, const ChunkColumn &column, CaveLattice &lattice)
 {
-	float *	factors = new float[CHUNK_WIDTH * CHUNK_WIDTH];
-	uint32_t	maxPos = MAX_WORLD_SIZE * CHUNK_WIDTH;
+	const int	step = (FULL_CAVES) ? 1 : CAVE_LATTICE_STEP;
+	const int	size = CHUNK_WIDTH / step + 1;
 
-	for (int i = 0; i < pow(CHUNK_WIDTH, 2); i++) {
-		float	factor = 0;
+	std::fill_n(factors, CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_HEIGHT, 0.0f);
 
-		factor += Noise::perlin2D(glm::vec2{(maxPos + pos.x + (i % CHUNK_WIDTH)) / 2.0f,
-				(maxPos + pos.z+ ((float)i / CHUNK_WIDTH)) / 2.0f}) * 2.0f;
-		factors[i] = pow(factor, 16.0f);
-	}
-	return (factors);
-}
+	if (lattice.cells < 0)
+		_computeCaveLattice(lattice, pos, column);
 
-float *	LayeredChunk::_computeHeightMap(const glm::ivec3 &pos)
-{
-	// Pre-compute the perlin noise factors
-	float		*factors = new float[CHUNK_WIDTH * CHUNK_WIDTH];
-	uint32_t	maxPos = MAX_WORLD_SIZE * CHUNK_WIDTH;
+	const int	cells = lattice.cells;
+	const int	layers = cells + 1;
+	const float	*points = lattice.points.data();
 
-	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
-		float	factor = 0;
-		float	amp = 128;
-		
-		for (int j = 0; j < 10; j++) {
-			factor += Noise::perlin2D(glm::vec2{(pos.x + maxPos + (i % CHUNK_WIDTH)) / (amp * 3),
-					(pos.z + maxPos + ((float)i / CHUNK_WIDTH)) / (amp * 3)}) * (amp / 2);
-
-			if (factor > 0)
-				factor = pow(factor, 1.03);
-			else
-				factor = -pow(fabsf(factor), 1.04);
-
-			amp -= amp / 2;
-		}
-		if (factor > 0)
-			factor = pow(factor, 1.1);
-		else
-			factor = factor * 0.2;
+	if (!cells)
+		return ;
 
-		factor += Noise::perlin2D(glm::vec2{(pos.x + (i % CHUNK_WIDTH)) / 2048,
-				(pos.z+ ((float)i / CHUNK_WIDTH)) / 2048}) * 512;
+	// Bilinear interpolation of each lattice layer on the x/z plane, then linear along y
+	float	layer[CHUNK_HEIGHT + 1];
 
-		factors[i] = factor;
-	}
-	return (factors);
-}
+	for (int bx = 0; bx < CHUNK_WIDTH; bx++) {
+		const int	lx = bx / step;
+		const float	wx = (float)(bx % step) / step;
 
-float **	LayeredChunk::_computeCaveNoise(const glm::ivec3 &pos, float *heightMap)
-{
-	float **	factors = new float*[CHUNK_WIDTH * CHUNK_WIDTH];
-	uint32_t	maxPos = MAX_WORLD_SIZE * CHUNK_WIDTH;
-	
-	for (int i = 0; i < (CHUNK_WIDTH * CHUNK_WIDTH); i+=1) {
-		float	factor = 0;
+		for (int bz = 0; bz < CHUNK_WIDTH; bz++) {
+			const int	lz = bz / step;
+			const float	wz = (float)(bz % step) / step;
+			const float	*c00 = &points[(lx * size + lz) * layers];
+			const float	*c01 = &points[(lx * size + lz + 1) * layers];
+			const float	*c10 = &points[((lx + 1) * size + lz) * layers];
+			const float	*c11 = &points[((lx + 1) * size + lz + 1) * layers];
+			float		*out = &factors[(bx * CHUNK_WIDTH + bz) * CHUNK_HEIGHT];
 
-		factors[i] = new float[CHUNK_WIDTH];
-		for (int j = 0; j < CHUNK_WIDTH; j+=1) {
-			float	amp = 20.0f;
+			for (int ly = 0; ly < layers; ly++) {
+				float	a = c00[ly] + (c01[ly] - c00[ly]) * wz;
+				float	b = c10[ly] + (c11[ly] - c10[ly]) * wz;
 
-			if (j + pos.y > heightMap[0]) {
-				factors[i][j] = 0;
-				continue ;
+				layer[ly] = a + (b - a) * wx;
+			}
+			for (int by = 0; by < cells * step; by++) {
+				const int	ly = by / step;
+
+				out[by] = layer[ly] + (layer[ly + 1] - layer[ly]) * ((float)(by % step) / step);
 			}
-			
-			float	x = (maxPos + pos.x + (i % CHUNK_WIDTH));
-			float	y = (maxPos + pos.y + j);
-			float	z = (maxPos + pos.z + ((float)i / CHUNK_WIDTH)) ;
-
-			factor = Noise::perlin3D({x / amp, y / amp, z / amp}) * amp;
-			amp = 120;
-			factor -= fabsf(Noise::perlin3D({x / amp, y / amp, z / amp}) * amp);
-			factors[i][j] = factor;
 		}
 	}
-	return (factors);
 }
 
 uint8_t	LayeredChunk::_getBiomeID(const int &idx, const float *heatFactors, const float *wetFactors)
@@ -295,21 +410,21 @@ void	LayeredChunk::_handleWorldFeatureOverflow(std::pair<glm::ivec3, WorldFeatur
 	if (newDir.x != 0 && dir.x == 0) {
 		newFeature._localPosition.z -= (CHUNK_WIDTH * newDir.z);
 		g_pendingFeaturesMutex.lock();
-		g_pendingFeatures.push_back(std::pair<glm::ivec3, WorldFeature>({wf.first.x, wf.first.y, wf.first.z + newDir.z}, newFeature));
+		g_pendingFeatures[{wf.first.x, wf.first.y, wf.first.z + newDir.z}].push_back(newFeature);
 		g_pendingFeaturesMutex.unlock();
 		dir.z = newDir.z;
 	}
 	else if (newDir.y != 0 && dir.y == 0) {
 		newFeature._localPosition.y -= (CHUNK_HEIGHT * newDir.y);
 		g_pendingFeaturesMutex.lock();
-		g_pendingFeatures.push_back(std::pair<glm::ivec3, WorldFeature>({wf.first.x, wf.first.y + newDir.y, wf.first.z}, newFeature));
+		g_pendingFeatures[{wf.first.x, wf.first.y + newDir.y, wf.first.z}].push_back(newFeature);
 		g_pendingFeaturesMutex.unlock();
 		dir.y = newDir.y;
 	}
 	else if (newDir.z != 0 && dir.z == 0) {
 		newFeature._localPosition.x -= (CHUNK_WIDTH * newDir.x);
 		g_pendingFeaturesMutex.lock();
-		g_pendingFeatures.push_back(std::pair<glm::ivec3, WorldFeature>({wf.first.x + newDir.x, wf.first.y, wf.first.z}, newFeature));
+		g_pendingFeatures[{wf.first.x + newDir.x, wf.first.y, wf.first.z}].push_back(newFeature);
 		g_pendingFeaturesMutex.unlock();
 		dir.x = newDir.x;
 	}
@@ -318,26 +433,65 @@ void	LayeredChunk::_handleWorldFeatureOverflow(std::pair<glm::ivec3, WorldFeatur
 /// ---
 
 /// Public methods
+bool	LayeredChunk::isUniform(const glm::ivec3 &pos, uint8_t &id, CaveLattice &lattice)
+{
+	glm::ivec3	wPos = {pos.x / CHUNK_WIDTH, pos.y / CHUNK_HEIGHT, pos.z / CHUNK_WIDTH};
+
+	// World features overflowing from a neighbour chunk would add blocks
+	g_pendingFeaturesMutex.lock();
+	bool	pending = g_pendingFeatures.count(wPos);
+	g_pendingFeaturesMutex.unlock();
+	if (pending)
+		return (false);
+
+	ChunkColumnPtr	column = ChunkColumnCache::get({wPos.x, wPos.z});
+
+	// Above the surface: only air, or water below the sea level
+	if (pos.y >= column->maxHeight && (pos.y > 0 || pos.y + CHUNK_HEIGHT - 1 <= 0)) {
+		id = (pos.y > 0) ? 0 : 9;
+		return (true);
+	}
+
+	// Under the stone layer of every biome: only stone, unless a cave reaches the chunk.
+	// The interpolated cave field never exceeds the highest of its lattice points.
+	if (pos.y + CHUNK_HEIGHT - 1 < (int)column->minHeight - 10) {
+		if (!NO_CAVES) {
+			_computeCaveLattice(lattice, pos, *column);
+			if (lattice.cells && *std::max_element(lattice.points.begin(), lattice.points.end()) >= 0.01f)
+				return (false);
+		}
+		id = 3;
+		return (true);
+	}
+	return (false);
+}
+
 void	LayeredChunk::generate(const glm::ivec3 &pos)
+{
+	CaveLattice	lattice;
+
+	generate(pos, lattice);
+}
+
+void	LayeredChunk::generate(const glm::ivec3 &pos, CaveLattice &lattice)
 {
 	glm::ivec3	wPos = {pos.x / CHUNK_WIDTH, pos.y / CHUNK_HEIGHT, pos.z / CHUNK_WIDTH};
 
 	std::list<std::pair<glm::ivec3, WorldFeature> >	localPendingFeatures;
 
-	WorldNoises	noises = {
-		_computeHeightMap(pos),
-		_computeHeatMap(pos),
-		_computeHumidityMap(pos),
-		_computeFeatureMap(pos),
+	// The 2D noise maps are shared with the other chunks of the column
+	ChunkColumnPtr		column = ChunkColumnCache::get({wPos.x, wPos.z});
+	const ChunkColumn &	noises = *column;
+	float *		caveFactors = nullptr;
+
+	if (!NO_CAVES) {
+		caveFactors = new float[CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_HEIGHT];
+		_computeCaveNoise(caveFactors, pos, noises, lattice);
+	}
+
+	// The blocks are generated in a flat array, each layer is built from it once complete
+	uint8_t	blocks[CHUNK_HEIGHT][CHUNK_WIDTH * CHUNK_WIDTH];
 
-	};
-	float **	caveFactors = (NO_CAVES) ? nullptr : _computeCaveNoise(pos, noises.heightMap);
-	
-	// Store the first block of each layer to handle decompression
-	uint8_t	fstBlkPerLayer[CHUNK_HEIGHT] = {0};
-	for (int i = pos.y; i < CHUNK_HEIGHT + pos.y; i++)
-		fstBlkPerLayer[i - pos.y] = (i < noises.heightMap[0]);
-	
 	// Populate the chunk according to the pre-computed perlin noise factors
 	for (int i = pos.x; i < CHUNK_WIDTH + pos.x; i++) {
 		for (int j = pos.z; j < CHUNK_WIDTH + pos.z; j++) {
@@ -349,7 +503,7 @@ void	LayeredChunk::generate(const glm::ivec3 &pos)
 
 			for (int k = pos.y; k < CHUNK_HEIGHT + pos.y; k++) {
 				// Get the current blockID according to the pre-computed factors
-				uint8_t	id = (NO_CAVES) ? _getBlockFromBiome(noises.heightMap[idx], k, biomeID) * ((k < noises.heightMap[idx])) : _getBlockFromBiome(noises.heightMap[idx], k, biomeID) * ((k < noises.heightMap[idx] && caveFactors[idx][k - pos.y] < 0.01f));
+				uint8_t	id = (NO_CAVES) ? _getBlockFromBiome(noises.heightMap[idx], k, biomeID) * ((k < noises.heightMap[idx])) : _getBlockFromBiome(noises.heightMap[idx], k, biomeID) * ((k < noises.heightMap[idx] && caveFactors[idx * CHUNK_HEIGHT + (k - pos.y)] < 0.01f));
 
 				if (k >= (int)noises.heightMap[idx] && k <= 0) {
 					if (id == 0)
@@ -357,13 +511,9 @@ void	LayeredChunk::generate(const glm::ivec3 &pos)
 					else if (id == 1 || id == 2)
 						id = 4;
 				}
-				
-				// Decompress the layer if needed
-				if (id != fstBlkPerLayer[k - pos.y] && dynamic_cast<SingleBlockChunkLayer *>(this->_layer[k - pos.y]))
-					this->_layer[k - pos.y] = _blockToLayer(this->_layer[k - pos.y]);
 
 				// Set the block
-				(*this->_layer[k - pos.y])[idx] = id;
+				blocks[k - pos.y][idx] = id;
 
 				// Add new pending World features to be generated
 				WorldFeature	newFeature = _getFeatureFromBiome(biomeID, {i - pos.x, k - pos.y, j - pos.z});
@@ -374,26 +524,15 @@ void	LayeredChunk::generate(const glm::ivec3 &pos)
 		}
 	}
 
-	if (!NO_CAVES) {
-		for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
-			delete [] caveFactors[i];
-		delete [] caveFactors;
-	}
-	delete [] noises.featuresMap;
-	delete [] noises.heatMap;
-	delete [] noises.humidityMap;
-	delete [] noises.heightMap;
+	delete [] caveFactors;
 
 	// Recover pending features from other bioms in global feature list
 	g_pendingFeaturesMutex.lock();
-	for (auto it = g_pendingFeatures.begin(); it != g_pendingFeatures.end();) {
-		if (it->first == wPos && it->second._origin == false) {
-			localPendingFeatures.push_back(*it);
-			g_pendingFeatures.erase(it);
-			it = g_pendingFeatures.begin();
-		}
-		else
-			it++;
+	auto	pending = g_pendingFeatures.find(wPos);
+	if (pending != g_pendingFeatures.end()) {
+		for (const WorldFeature &feature : pending->second)
+			localPendingFeatures.push_back(std::pair(wPos, feature));
+		g_pendingFeatures.erase(pending);
 	}
 	g_pendingFeaturesMutex.unlock();
 
@@ -438,12 +577,8 @@ void	LayeredChunk::generate(const glm::ivec3 &pos)
 				continue ;
 			}
 
-			// Decompress the layer if needed
-			if (it->second._data[i].w != fstBlkPerLayer[it->second._localPosition.y + it->second._data[i].y] && dynamic_cast<SingleBlockChunkLayer *>(this->_layer[it->second._localPosition.y + it->second._data[i].y]))
-				this->_layer[it->second._localPosition.y + it->second._data[i].y] = _blockToLayer(this->_layer[it->second._localPosition.y + it->second._data[i].y]);
-			
 			// Set the block
-			(*this->_layer[it->second._localPosition.y + it->second._data[i].y])[idx] = it->second._data[i].w;
+			blocks[it->second._localPosition.y + it->second._data[i].y][idx] = it->second._data[i].w;
 		}
 		// Reset the function static variable for future usage
 		_handleWorldFeatureOverflow(*it, {0, 0, 0}, true);
@@ -452,12 +587,39 @@ void	LayeredChunk::generate(const glm::ivec3 &pos)
 		localPendingFeatures.erase(it);
 		it = localPendingFeatures.begin();
 	}
+
+	for (int y = 0; y < CHUNK_HEIGHT; y++)
+		_setLayer(y, blocks[y]);
+	_buildOccupancy(blocks);
+}
+
+// Only the decompressed layers are checked, a chunk made uniform is collapsed by ChunkHandler::recompactChunk
+size_t	LayeredChunk::recompact()
+{
+	size_t	count = 0;
+
+	for (int y = 0; y < CHUNK_HEIGHT; y++) {
+		if (this->_layers[y]->getType() == LayerType::SINGLE_BLOCK || !this->_layers[y]->isUniform())
+			continue;
+		this->_layers[y] = _layerToBlock(this->_layers[y]);
+		count++;
+	}
+	return (count);
+}
+
+size_t	LayeredChunk::getMemoryUsage() const
+{
+	size_t	usage = sizeof(LayeredChunk) + sizeof(AChunkLayer *) * CHUNK_HEIGHT;
+
+	for (int y = 0; y < CHUNK_HEIGHT; y++)
+		usage += this->_layers[y]->getMemoryUsage();
+	return (usage);
 }
 
 void	LayeredChunk::print()
 {
 	for (int i = 0; i < CHUNK_HEIGHT; i++) {
-		this->_layer[i]->print();
+		this->_layers[i]->print();
 		std::cout << "\n---------------------------------------------------------------------------------------------------" << std::endl;
 	}
 }
@@ -466,19 +628,25 @@ void	LayeredChunk::setBlock(const glm::ivec3 &pos, const uint8_t &blockID)
 {
 	uint32_t	idx = pos.x * CHUNK_WIDTH + pos.z;
 
-	if (dynamic_cast<SingleBlockChunkLayer *>(this->_layer[pos.y]))
-		this->_layer[pos.y] = _blockToLayer(this->_layer[pos.y]);
-	(*this->_layer[pos.y])[idx] = blockID;
+	if (this->_layers[pos.y]->getType() == LayerType::SINGLE_BLOCK)
+		this->_layers[pos.y] = _blockToLayer(this->_layers[pos.y]);
+	this->_layers[pos.y]->set(idx, blockID);
+
+	uint32_t &	column = this->_masks[pos.y * CHUNK_WIDTH + pos.x];
+
+	column = (column & ~(1u << pos.z)) | ((uint32_t)(blockID != 0) << pos.z);
 }
 
 /// ---
 
 /// Private methods
-ChunkLayer		* LayeredChunk::_blockToLayer(AChunkLayer *layer)
+AChunkLayer		* LayeredChunk::_blockToLayer(AChunkLayer *layer)
 {
 	uint8_t	id = (*layer)[0];
 	delete layer;
 
+	if (PACKED_LAYERS)
+		return (new PackedChunkLayer(id));
 	return (new ChunkLayer(id));
 }
 
@@ -489,6 +657,43 @@ SingleBlockChunkLayer	* LayeredChunk::_layerToBlock(AChunkLayer *layer)
 	
 	return (new SingleBlockChunkLayer(id));
 }
+
+// Replace the layer y by the most compact layer type holding these blocks
+void	LayeredChunk::_setLayer(const size_t &y, const uint8_t *blocks)
+{
+	AChunkLayer *	layer;
+
+	if (isUniformLayer(blocks)) {
+		// Already compressed, only the id changes
+		if (this->_layers[y]->getType() == LayerType::SINGLE_BLOCK) {
+			this->_layers[y]->set(0, blocks[0]);
+			return ;
+		}
+		layer = new SingleBlockChunkLayer(blocks[0]);
+	}
+	else if (PACKED_LAYERS)
+		layer = new PackedChunkLayer(blocks);
+	else
+		layer = new ChunkLayer(blocks);
+
+	delete this->_layers[y];
+	this->_layers[y] = layer;
+}
+
+// Rebuild the occupancy mask from the generated blocks
+void	LayeredChunk::_buildOccupancy(const uint8_t (*blocks)[CHUNK_WIDTH * CHUNK_WIDTH])
+{
+	for (size_t y = 0; y < CHUNK_HEIGHT; y++) {
+		uint32_t *	columns = this->_masks + y * CHUNK_WIDTH;
+
+		if (IS_LAYER_COMPRESSED(this, y))
+			std::fill(columns, columns + CHUNK_WIDTH, blocks[y][0] ? OCCUPANCY_SOLID : 0);
+		else {
+			for (size_t x = 0; x < CHUNK_WIDTH; x++)
+				columns[x] = solidBits(blocks[y] + x * CHUNK_WIDTH);
+		}
+	}
+}
 /// ---
 
 //// ---
@@ -496,32 +701,71 @@ SingleBlockChunkLayer	* LayeredChunk::_layerToBlock(AChunkLayer *layer)
 //// SingleBlockChunk class
 
 /// Constructors & Destructors
-SingleBlockChunk::SingleBlockChunk(const uint8_t &id) : _id(new SingleBlockChunkLayer(id)) {}
-
-SingleBlockChunk::~SingleBlockChunk()
+SingleBlockChunk::SingleBlockChunk(const uint8_t &id) : AChunk(ChunkType::SINGLE_BLOCK), _layer(id), _layerPtr(&_layer), _refCount(0)
 {
-	delete this->_id;
+	this->_layers = &this->_layerPtr;
+	this->_layerMask = 0;
+
+	// Created with the instances mutex locked, the solid masks are filled by the first one
+	if (!_solidOccupancy[0])
+		std::fill(_solidOccupancy, _solidOccupancy + OCCUPANCY_SIZE, OCCUPANCY_SOLID);
+	this->_occupancy = id ? _solidOccupancy : _emptyOccupancy;
 }
-/// ---
 
-/// Operator Overloads
-AChunkLayer *	& SingleBlockChunk::operator[](const size_t &i)
+SingleBlockChunk::~SingleBlockChunk() {}
+
+SingleBlockChunk::Instances::~Instances()
 {
-	(void)i;
-	return (this->_id);
+	for (size_t id = 0; id < 256; id++)
+		delete chunks[id].load();
 }
 /// ---
 
 /// public methods
+SingleBlockChunk *	SingleBlockChunk::acquire(const uint8_t &id)
+{
+	SingleBlockChunk *	chunk = _instances.chunks[id].load(std::memory_order_acquire);
+
+	if (!chunk) {
+		std::lock_guard<std::mutex>	lock(_instances.mutex);
+
+		chunk = _instances.chunks[id].load(std::memory_order_relaxed);
+		if (!chunk) {
+			chunk = new SingleBlockChunk(id);
+			_instances.chunks[id].store(chunk, std::memory_order_release);
+		}
+	}
+
+	chunk->_refCount.fetch_add(1, std::memory_order_relaxed);
+	return (chunk);
+}
+
+// The instance is kept with no reference left, the next chunk of this block reuses it
+void	SingleBlockChunk::release()
+{
+	this->_refCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32_t	SingleBlockChunk::getRefCount() const
+{
+	return (this->_refCount.load(std::memory_order_relaxed));
+}
+
 void	SingleBlockChunk::print()
 {
-	this->_id->print();
+	this->_layer.print();
 }
 
 void	SingleBlockChunk::generate(const glm::ivec3 &pos) { (void)pos; }
 
 void	SingleBlockChunk::setBlock(const glm::ivec3 &pos, const uint8_t &blockID) { (void)pos; (void)blockID; }
 
+// Shared by every chunk of its block, none of them holds any memory of its own
+size_t	SingleBlockChunk::getMemoryUsage() const
+{
+	return (0);
+}
+
 /// ---
 
 //// ---
@@ -529,26 +773,50 @@ void	SingleBlockChunk::setBlock(const glm::ivec3 &pos, const uint8_t &blockID) {
 //// AChunkLayer class
 
 /// Constructors & Destructors
-AChunkLayer:: AChunkLayer() {}
+AChunkLayer:: AChunkLayer(const LayerType &type) : _type(type) {}
 AChunkLayer::~AChunkLayer() {}
 /// ---
 
 //// SingleBlockChunkLayer class
 
 /// Constructors & Destructors
-SingleBlockChunkLayer::SingleBlockChunkLayer(const uint8_t &id) : _id(id) {}
+SingleBlockChunkLayer::SingleBlockChunkLayer(const uint8_t &id) : AChunkLayer(LayerType::SINGLE_BLOCK), _id(id) {}
 SingleBlockChunkLayer::~SingleBlockChunkLayer() {}
-/// ---
 
-/// Operator Overloads
-uint8_t	& SingleBlockChunkLayer::operator[](const size_t &i)
+void *	SingleBlockChunkLayer::operator new(size_t size)
 {
-	(void)i;
-	return (this->_id);
+	(void)size;
+	return (_pool.allocate());
+}
+
+void	SingleBlockChunkLayer::operator delete(void *ptr)
+{
+	_pool.deallocate(ptr);
 }
 /// ---
 
 /// public methods
+void	SingleBlockChunkLayer::set(const size_t &i, const uint8_t &id)
+{
+	(void)i;
+	this->_id = id;
+}
+
+void	SingleBlockChunkLayer::copyTo(uint8_t *dst) const
+{
+	memset(dst, this->_id, CHUNK_WIDTH * CHUNK_WIDTH);
+}
+
+bool	SingleBlockChunkLayer::isUniform() const
+{
+	return (true);
+}
+
+size_t	SingleBlockChunkLayer::getMemoryUsage() const
+{
+	return (sizeof(SingleBlockChunkLayer));
+}
+
 void	SingleBlockChunkLayer::print()
 {
 	if (this->_id)
@@ -562,24 +830,74 @@ void	SingleBlockChunkLayer::print()
 //// ChunkLayer class
 
 /// Constructors & Destructors
-ChunkLayer::ChunkLayer(const uint8_t &id) : _data(new uint8_t[CHUNK_WIDTH * CHUNK_WIDTH])
+ChunkLayer::ChunkLayer(const uint8_t &id) : AChunkLayer(LayerType::BYTES), _data((uint8_t *)_dataPool.allocate()), _shared(nullptr)
 {
 	memset(this->_data, id, CHUNK_WIDTH * CHUNK_WIDTH);
 }
+ChunkLayer::ChunkLayer(const uint8_t *blocks) : AChunkLayer(LayerType::BYTES), _data(nullptr), _shared(nullptr)
+{
+	if (INTERN_LAYERS) {
+		this->_shared = ChunkLayerStore::acquire(blocks);
+		this->_data = this->_shared->blocks;
+		return ;
+	}
+	this->_data = (uint8_t *)_dataPool.allocate();
+	memcpy(this->_data, blocks, CHUNK_WIDTH * CHUNK_WIDTH);
+}
 ChunkLayer::~ChunkLayer()
 {
-	delete [] this->_data;
+	if (this->_shared)
+		ChunkLayerStore::release(this->_shared);
+	else
+		_dataPool.deallocate(this->_data);
 }
-/// ---
 
-/// Operator Overloads
-uint8_t	& ChunkLayer::operator[](const size_t &i)
+void *	ChunkLayer::operator new(size_t size)
 {
-	return (this->_data[i]);
+	(void)size;
+	return (_pool.allocate());
+}
+
+void	ChunkLayer::operator delete(void *ptr)
+{
+	_pool.deallocate(ptr);
 }
 /// ---
 
 /// public methods
+// A shared buffer is copied first, the other layers using it keep their blocks
+void	ChunkLayer::set(const size_t &i, const uint8_t &id)
+{
+	if (this->_data[i] == id)
+		return ;
+
+	if (this->_shared) {
+		this->_data = (uint8_t *)_dataPool.allocate();
+		memcpy(this->_data, this->_shared->blocks, CHUNK_WIDTH * CHUNK_WIDTH);
+		ChunkLayerStore::release(this->_shared);
+		this->_shared = nullptr;
+	}
+	this->_data[i] = id;
+}
+
+void	ChunkLayer::copyTo(uint8_t *dst) const
+{
+	memcpy(dst, this->_data, CHUNK_WIDTH * CHUNK_WIDTH);
+}
+
+bool	ChunkLayer::isUniform() const
+{
+	return (isUniformLayer(this->_data));
+}
+
+// A shared buffer is split between the layers using it
+size_t	ChunkLayer::getMemoryUsage() const
+{
+	if (this->_shared)
+		return (sizeof(ChunkLayer) + CHUNK_WIDTH * CHUNK_WIDTH / this->_shared->refCount.load(std::memory_order_relaxed));
+	return (sizeof(ChunkLayer) + CHUNK_WIDTH * CHUNK_WIDTH);
+}
+
 void	ChunkLayer::print()
 {
 	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
@@ -593,3 +911,216 @@ void	ChunkLayer::print()
 /// ---
 
 //// ---
+
+//// PackedChunkLayer class
+
+// Width known at compile time, so the inner loop is unrolled
+template <size_t Width>
+static inline void	unpackIndices(uint8_t *dst, const uint64_t *bits, const uint8_t *palette)
+{
+	const uint64_t	mask = (1ull << Width) - 1;
+
+	for (size_t word = 0; word < CHUNK_WIDTH * CHUNK_WIDTH * Width / 64; word++) {
+		uint64_t	value = bits[word];
+
+		for (size_t i = 0; i < 64 / Width; i++, value >>= Width)
+			*dst++ = palette[value & mask];
+	}
+}
+
+/// Constructors & Destructors
+PackedChunkLayer::PackedChunkLayer(const uint8_t &id)
+	: AChunkLayer(LayerType::PACKED), _palette(1, id), _counts(1, CHUNK_WIDTH * CHUNK_WIDTH), _bits(_allocateBits(0)), _shift(0), _used(1)
+{
+}
+
+// The palette is in order of appearance and the indices as narrow as it allows
+PackedChunkLayer::PackedChunkLayer(const uint8_t *blocks) : AChunkLayer(LayerType::PACKED), _bits(nullptr), _shift(0), _used(0)
+{
+	int16_t	entries[256]; // Block id -> palette entry
+
+	std::fill_n(entries, 256, -1);
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+		if (entries[blocks[i]] < 0) {
+			entries[blocks[i]] = this->_palette.size();
+			this->_palette.push_back(blocks[i]);
+			this->_counts.push_back(0);
+		}
+		this->_counts[entries[blocks[i]]]++;
+	}
+
+	this->_used = this->_palette.size();
+	while (this->_used > (1u << (1 << this->_shift)))
+		this->_shift++;
+
+	this->_bits = _allocateBits(this->_shift);
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+		this->_bits[i >> (6 - this->_shift)] |= (uint64_t)entries[blocks[i]] << ((i << this->_shift) & 63);
+}
+
+PackedChunkLayer::~PackedChunkLayer()
+{
+	_bitsPools[this->_shift].deallocate(this->_bits);
+}
+
+void *	PackedChunkLayer::operator new(size_t size)
+{
+	(void)size;
+	return (_pool.allocate());
+}
+
+void	PackedChunkLayer::operator delete(void *ptr)
+{
+	_pool.deallocate(ptr);
+}
+/// ---
+
+/// Private methods
+uint64_t *	PackedChunkLayer::_allocateBits(const uint8_t &shift)
+{
+	uint64_t *	bits = (uint64_t *)_bitsPools[shift].allocate();
+
+	memset(bits, 0, (CHUNK_WIDTH * CHUNK_WIDTH << shift) / 8);
+	return (bits);
+}
+
+void	PackedChunkLayer::_setIndex(const size_t &i, const uint32_t &index)
+{
+	const uint64_t	mask = (1ull << (1 << this->_shift)) - 1;
+	const size_t	offset = (i << this->_shift) & 63;
+	uint64_t &	word = this->_bits[i >> (6 - this->_shift)];
+
+	word = (word & ~(mask << offset)) | ((uint64_t)index << offset);
+}
+
+// Store a block id missing from the palette for one block, in a free entry if any
+// The indices are widened if the palette outgrows them
+uint32_t	PackedChunkLayer::_addEntry(const uint8_t &id)
+{
+	this->_used++;
+	for (size_t entry = 0; entry < this->_palette.size(); entry++) {
+		if (!this->_counts[entry]) {
+			this->_palette[entry] = id;
+			this->_counts[entry] = 1;
+			return (entry);
+		}
+	}
+
+	this->_palette.push_back(id);
+	this->_counts.push_back(1);
+	if (this->_palette.size() > (1u << (1 << this->_shift)))
+		_repack(this->_shift + 1);
+	return (this->_palette.size() - 1);
+}
+
+// Rebuild the indices with 2^shift bits per block, the free palette entries are dropped
+void	PackedChunkLayer::_repack(const uint8_t &shift)
+{
+	std::vector<uint8_t>	palette;
+	std::vector<uint16_t>	counts;
+	uint32_t		remap[256];
+	uint64_t *		bits = _allocateBits(shift);
+
+	palette.reserve(this->_used);
+	counts.reserve(this->_used);
+	for (size_t entry = 0; entry < this->_palette.size(); entry++) {
+		if (!this->_counts[entry])
+			continue;
+		remap[entry] = palette.size();
+		palette.push_back(this->_palette[entry]);
+		counts.push_back(this->_counts[entry]);
+	}
+
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+		bits[i >> (6 - shift)] |= (uint64_t)remap[_index(i)] << ((i << shift) & 63);
+
+	_bitsPools[this->_shift].deallocate(this->_bits);
+	this->_bits = bits;
+	this->_shift = shift;
+	this->_palette.swap(palette);
+	this->_counts.swap(counts);
+}
+/// ---
+
+/// public methods
+void	PackedChunkLayer::set(const size_t &i, const uint8_t &id)
+{
+	const uint32_t	previous = _index(i);
+	uint32_t	entry = this->_palette.size();
+
+	if (this->_palette[previous] == id)
+		return ;
+
+	for (size_t e = 0; e < this->_palette.size(); e++) {
+		if (this->_counts[e] && this->_palette[e] == id) {
+			entry = e;
+			break ;
+		}
+	}
+
+	// Last block of its id replaced by a new id, the entry is simply renamed
+	if (entry == this->_palette.size() && this->_counts[previous] == 1) {
+		this->_palette[previous] = id;
+		return ;
+	}
+
+	if (entry == this->_palette.size())
+		entry = _addEntry(id);
+	else
+		this->_counts[entry]++;
+	_setIndex(i, entry);
+
+	if (--this->_counts[previous])
+		return ;
+	this->_used--;
+
+	// Narrow the indices once the palette fits in half of the narrower range,
+	// so an id coming and going around the limit does not repack the layer every time
+	const uint8_t	width = 1 << this->_shift;
+
+	if (this->_shift && this->_used <= (1u << (width / 2)) / 2) {
+		uint8_t	shift = 0;
+
+		while (this->_used > (1u << (1 << shift)))
+			shift++;
+		_repack(shift);
+	}
+}
+
+void	PackedChunkLayer::copyTo(uint8_t *dst) const
+{
+	switch (this->_shift) {
+		case 0: unpackIndices<1>(dst, this->_bits, this->_palette.data()); break;
+		case 1: unpackIndices<2>(dst, this->_bits, this->_palette.data()); break;
+		case 2: unpackIndices<4>(dst, this->_bits, this->_palette.data()); break;
+		default: unpackIndices<8>(dst, this->_bits, this->_palette.data()); break;
+	}
+}
+
+// The counts already tell it, a layer with a single id left keeps one entry
+bool	PackedChunkLayer::isUniform() const
+{
+	return (this->_used == 1);
+}
+
+size_t	PackedChunkLayer::getMemoryUsage() const
+{
+	return (sizeof(PackedChunkLayer)
+		+ this->_palette.capacity() * sizeof(uint8_t)
+		+ this->_counts.capacity() * sizeof(uint16_t)
+		+ (CHUNK_WIDTH * CHUNK_WIDTH << this->_shift) / 8);
+}
+
+void	PackedChunkLayer::print()
+{
+	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
+		if ((*this)[i])
+			std::cout << " #";
+		else std::cout << " .";
+		if (!(i % CHUNK_WIDTH))
+			std::cout << std::endl;
+	}
+}
+/// ---
+
+//// ---
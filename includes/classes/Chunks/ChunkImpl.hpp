@@ -2,16 +2,23 @@
 
 /// Defines
 # define GLM_ENABLE_EXPERIMENTAL
+# define CAVE_LATTICE_STEP	4 // Distance in blocks between two cave noise samples, must divide CHUNK_WIDTH (--full-caves samples every block)
 
 /// System includes
+# include <atomic>
 # include <cstdint>
 # include <cstring>
 # include <list>
+# include <mutex>
 # include <unordered_map>
+# include <vector>
 
 /// Dependencies
 # include "glm/gtx/hash.hpp"
 # include "AChunk.hpp"
+# include "ChunkColumn.hpp"
+# include "ChunkLayerStore.hpp"
+# include "SlabPool.hpp"
 
 enum	EnvParams {
 	DRY = 0,
@@ -46,23 +53,44 @@ enum e_worldFeatures {
 	WF_SNOW_TREE
 };
 
-typedef struct WorldNoises {
-	float *	heightMap;
-	float * heatMap;
-	float *	humidityMap;
-	float * featuresMap;
-}	WorldNoises;
+// Cave noise lattice of a chunk, evaluated once and shared by LayeredChunk::isUniform and LayeredChunk::generate
+typedef struct CaveLattice {
+	std::vector<float>	points; // Layout described in LayeredChunk::_computeCaveLattice
+	int			cells = -1; // Lattice cells along y under the surface, -1 until evaluated
+} CaveLattice;
 
 /// Global variables
-extern std::list<std::pair<glm::ivec3, WorldFeature> >	g_pendingFeatures;
+// Features overflowing from a generated chunk into a neighbour not generated yet, by neighbour position
+extern std::unordered_map<glm::ivec3, std::list<WorldFeature> >	g_pendingFeatures;
+
+// Tag of the concrete layer type, checked instead of a dynamic_cast
+enum class LayerType : uint8_t {
+	SINGLE_BLOCK,
+	BYTES,
+	PACKED
+};
 
 // Chunk layer interface.
+// Reading a block is not virtual, operator[] switches on the tag to the inlined accessor of the layer type.
 class	AChunkLayer {
+	protected:
+		LayerType	_type;
+
 	public:
-		AChunkLayer();
+		AChunkLayer(const LayerType &type);
 		virtual ~AChunkLayer() = 0;
 
-		virtual uint8_t	& operator[](const size_t &i) = 0;
+		// Block id at i, the blocks are changed through set
+		uint8_t		operator[](const size_t &i) const;
+		LayerType	getType() const { return (this->_type); }
+
+		virtual void	set(const size_t &i, const uint8_t &id) = 0;
+		// Copy the CHUNK_WIDTH * CHUNK_WIDTH block ids of the layer to dst
+		virtual void	copyTo(uint8_t *dst) const = 0;
+		// True if every block of the layer has the same id
+		virtual bool	isUniform() const = 0;
+		// Bytes held by the layer and its blocks
+		virtual size_t	getMemoryUsage() const = 0;
 
 		virtual void	print() = 0;
 };
@@ -73,77 +101,206 @@ class	SingleBlockChunkLayer : public AChunkLayer {
 	private:
 		uint8_t	_id;
 
+		static SlabPool	_pool;
+
 	public:
 		SingleBlockChunkLayer(const uint8_t &id);
 		~SingleBlockChunkLayer();
 
+		// Allocated from _pool
+		void *	operator new(size_t size);
+		void	operator delete(void *ptr);
+
 		// Allways return the block id of the layered no matter the value i.
 		// This avoid compatibility issues with other type of layers
-		uint8_t	& operator[](const size_t &i);
+		uint8_t	get(const size_t &i) const { (void)i; return (this->_id); }
+
+		// Change the block id of the whole layer
+		void	set(const size_t &i, const uint8_t &id);
+		void	copyTo(uint8_t *dst) const;
+		bool	isUniform() const;
+		size_t	getMemoryUsage() const;
 
 		void	print();
 };
 
 // Default chunk layer.
 // Stores an array of bytes that are indices to the chunk block palette.
+// With INTERN_LAYERS, a generated layer shares its bytes with the identical layers through the ChunkLayerStore
+// until it is edited.
 class	ChunkLayer : public AChunkLayer {
 	private:
 		uint8_t	*_data;
+		ChunkLayerStore::Entry *	_shared; // Buffer of _data when interned, nullptr when _data is owned
+
+		static SlabPool	_pool;
+		static SlabPool	_dataPool; // CHUNK_WIDTH * CHUNK_WIDTH blocks
 
 	public:
 		ChunkLayer(const uint8_t &id);
+		ChunkLayer(const uint8_t *blocks);
 		~ChunkLayer();
-	
-		uint8_t	& operator[](const size_t &i);
+
+		// Allocated from _pool
+		void *	operator new(size_t size);
+		void	operator delete(void *ptr);
+
+		uint8_t		get(const size_t &i) const { return (this->_data[i]); }
+		const uint8_t *	getData() const { return (this->_data); }
+
+		void	set(const size_t &i, const uint8_t &id);
+		void	copyTo(uint8_t *dst) const;
+		bool	isUniform() const;
+		size_t	getMemoryUsage() const;
+
+		void	print();
+};
+
+// Bit-packed chunk layer.
+// Stores its own palette of block ids and, for each block, the index of its id in the palette on 1, 2, 4 or 8 bits.
+// The indices are widened when a new block id does not fit in the palette,
+// and narrowed again once most of the ids are gone, so a layer with a few block types stays small.
+class	PackedChunkLayer : public AChunkLayer {
+	private:
+		std::vector<uint8_t>	_palette; // Block ids, an entry is free once its count is 0
+		std::vector<uint16_t>	_counts; // Blocks of the layer using each palette entry
+		uint64_t *	_bits; // Indices to the palette, never across two words
+		uint8_t		_shift; // log2 of the bits per block
+		uint16_t	_used; // Palette entries with a count
+
+		static SlabPool	_pool;
+		static SlabPool	_bitsPools[4]; // Indices of a layer for each shift
+
+		// The word of block i is i / (64 / width) and its offset i * width % 64
+		uint32_t	_index(const size_t &i) const {
+			return ((this->_bits[i >> (6 - this->_shift)] >> ((i << this->_shift) & 63)) & ((1ull << (1 << this->_shift)) - 1));
+		}
+		static uint64_t *	_allocateBits(const uint8_t &shift); // Zeroed
+		void		_setIndex(const size_t &i, const uint32_t &index);
+		uint32_t	_addEntry(const uint8_t &id);
+		void		_repack(const uint8_t &shift);
+
+	public:
+		PackedChunkLayer(const uint8_t &id);
+		PackedChunkLayer(const uint8_t *blocks);
+		~PackedChunkLayer();
+
+		// Allocated from _pool
+		void *	operator new(size_t size);
+		void	operator delete(void *ptr);
+
+		uint8_t	get(const size_t &i) const { return (this->_palette[_index(i)]); }
+
+		void	set(const size_t &i, const uint8_t &id);
+		void	copyTo(uint8_t *dst) const;
+		bool	isUniform() const;
+		// Bytes held by the layer, its palette and its indices
+		size_t	getMemoryUsage() const;
 
 		void	print();
 };
 
 // Default type of chunk.
 // Contain a abstract type that stores a layer of block.
+// Its occupancy mask is rebuilt by generate and updated bit by bit by setBlock.
 class	LayeredChunk : public AChunk {
 	private:
-		AChunkLayer **	_layer;
-
-		float *		_computeHeatMap(const glm::ivec3 &pos);
-		float *		_computeHeightMap(const glm::ivec3 &pos);
-		float *		_computeHumidityMap(const glm::ivec3 &pos);
-		float *		_computeFeatureMap(const glm::ivec3 &pos);
-		float **	_computeCaveNoise(const glm::ivec3 &pos, float *heightMap);
+		static void	_computeCaveLattice(CaveLattice &lattice, const glm::ivec3 &pos, const ChunkColumn &column);
+		void		_computeCaveNoise(float *factors, const glm::ivec3 &pos, const ChunkColumn &column, CaveLattice &lattice);
 
 		uint8_t	_getBiomeID(const int &idx, const float *heatFactors, const float *wetFactors);
 		uint8_t	_getBlockFromBiome(const int &surface, const int &y, const uint8_t &biomeID);
 		WorldFeature	_getFeatureFromBiome(const uint8_t &biomeID, const glm::ivec3 pos);
 		void	_handleWorldFeatureOverflow(std::pair<glm::ivec3, WorldFeature> wf, glm::ivec3 newDir, const bool reset);
 		
-		ChunkLayer *		_blockToLayer(AChunkLayer *layer);
+		AChunkLayer *		_blockToLayer(AChunkLayer *layer);
 		SingleBlockChunkLayer *	_layerToBlock(AChunkLayer *layer);
+		void			_setLayer(const size_t &y, const uint8_t *blocks);
+		void			_buildOccupancy(const uint8_t (*blocks)[CHUNK_WIDTH * CHUNK_WIDTH]);
+
+		uint32_t	_masks[OCCUPANCY_SIZE]; // Storage of _occupancy
+
+		static SlabPool	_pool;
+		static SlabPool	_layersPool; // Arrays of CHUNK_HEIGHT layers
 	public:
 		LayeredChunk(const uint8_t &id);
 		~LayeredChunk();
 
+		// Allocated from _pool
+		void *	operator new(size_t size);
+		void	operator delete(void *ptr);
+
+		// Tell if the chunk at pos (world coordinates) would only hold a single block, without generating it.
+		// Cheap bounds of the column are used, so some uniform chunks are still reported as not uniform.
+		// The cave lattice evaluated for deep chunks is kept in "lattice", to be given to generate.
+		static bool	isUniform(const glm::ivec3 &pos, uint8_t &id, CaveLattice &lattice);
+
 		void	generate(const glm::ivec3 &pos);
+		// Same, reusing the cave lattice of isUniform if it was evaluated
+		void	generate(const glm::ivec3 &pos, CaveLattice &lattice);
 
-		AChunkLayer *	& operator[](const size_t &i);
+		// Compress back the layers made uniform by the edits, return how many were
+		size_t	recompact();
+		size_t	getMemoryUsage() const;
 
 		// Debugging method. Will not be used in the final release.
 		void		print();
 		void		setBlock(const glm::ivec3 &pos, const uint8_t &blockID);
 };
 
+// Chunk filled with a single block id.
+// Immutable and shared: there is one instance per block id, handed out by acquire and given back by release
+// (ChunkHandler::releaseChunk), so a uniform chunk costs no allocation. Editing one goes through ChunkHandler::setBlock,
+// which replaces it by a LayeredChunk.
 class	SingleBlockChunk : public AChunk {
 	private:
-		// This member will only be intenciated has a "SingleBlockChunkLayer".
-		// An abstract type is used for compatibility with other chunk types.
-		AChunkLayer	*_id;
-	
-	public:
+		// Instances of each block id, created on first use and deleted at exit
+		typedef struct Instances {
+			std::atomic<SingleBlockChunk *>	chunks[256];
+			std::mutex			mutex; // Only taken to create an instance
+
+			~Instances();
+		} Instances;
+
+		SingleBlockChunkLayer	_layer;
+		AChunkLayer *		_layerPtr; // The only entry of _layers
+		std::atomic<uint32_t>	_refCount; // Chunks of the world sharing the instance
+
+		static Instances	_instances;
+		static uint32_t		_solidOccupancy[OCCUPANCY_SIZE]; // Shared by the instances of every non-air block
+		static uint32_t		_emptyOccupancy[OCCUPANCY_SIZE];
+
 		SingleBlockChunk(const uint8_t &id);
 		~SingleBlockChunk();
 
-		AChunkLayer *	& operator[](const size_t &i);
-		
+	public:
+		// Shared chunk filled with id, to give back with release
+		static SingleBlockChunk *	acquire(const uint8_t &id);
+		void				release();
+		uint32_t			getRefCount() const;
+
 		void	print();
 		void	generate(const glm::ivec3 &pos);
 		void	setBlock(const glm::ivec3 &pos, const uint8_t &blockID);
+		size_t	getMemoryUsage() const;
 };
+
+/// Inline functions, used by every block access
+
+inline uint8_t	AChunkLayer::operator[](const size_t &i) const
+{
+	switch (this->_type) {
+		case LayerType::BYTES:
+			return (static_cast<const ChunkLayer *>(this)->get(i));
+		case LayerType::SINGLE_BLOCK:
+			return (static_cast<const SingleBlockChunkLayer *>(this)->get(i));
+		default:
+			return (static_cast<const PackedChunkLayer *>(this)->get(i));
+	}
+}
+
+inline uint8_t	AChunk::getBlock(const size_t &x, const size_t &y, const size_t &z) const
+{
+	return ((*this->_layers[y & this->_layerMask])[x * CHUNK_WIDTH + z]);
+}
+/// ---
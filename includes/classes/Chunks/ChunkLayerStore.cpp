@@ -0,0 +1,112 @@
+/// Class independant system includes
+# include <cstring>
+# include <iostream>
+# include <new>
+
+# include "ChunkLayerStore.hpp"
+
+ChunkLayerStore::Shard	ChunkLayerStore::_shards[LAYER_STORE_SHARDS];
+SlabPool		ChunkLayerStore::_pool("ChunkLayerStore buffers", sizeof(ChunkLayerStore::Entry));
+
+//// ChunkLayerStore class
+
+/// Private Methods
+
+// 4 independent multiply-xor lanes over the 64 bits words, so the multiplications do not wait on each other
+uint64_t	ChunkLayerStore::_hash(const uint8_t *blocks)
+{
+	const uint64_t	prime = 0x9E3779B97F4A7C15ull;
+	uint64_t	lanes[4] = {1, 2, 3, 4};
+
+	for (size_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i += 4 * sizeof(uint64_t)) {
+		for (size_t lane = 0; lane < 4; lane++) {
+			uint64_t	word;
+
+			memcpy(&word, blocks + i + lane * sizeof(uint64_t), sizeof(uint64_t));
+			lanes[lane] = (lanes[lane] ^ word) * prime;
+			lanes[lane] ^= lanes[lane] >> 29;
+		}
+	}
+
+	uint64_t	hash = lanes[0] ^ (lanes[1] * prime) ^ (lanes[2] * prime * prime) ^ (lanes[3] * prime * prime * prime);
+
+	hash ^= hash >> 32;
+	return (hash);
+}
+/// ---
+
+/// Public methods
+ChunkLayerStore::Entry *	ChunkLayerStore::acquire(const uint8_t *blocks)
+{
+	const uint64_t			hash = _hash(blocks);
+	Shard &				shard = _shards[hash % LAYER_STORE_SHARDS];
+	std::lock_guard<std::mutex>	lock(shard.mutex);
+	auto				range = shard.entries.equal_range(hash);
+
+	shard.lookups++;
+	shard.layers++;
+	for (auto it = range.first; it != range.second; it++) {
+		if (!memcmp(it->second->blocks, blocks, CHUNK_WIDTH * CHUNK_WIDTH)) {
+			it->second->refCount.fetch_add(1, std::memory_order_relaxed);
+			shard.hits++;
+			return (it->second);
+		}
+	}
+
+	Entry *	entry = (Entry *)_pool.allocate();
+
+	entry->hash = hash;
+	new (&entry->refCount) std::atomic<uint32_t>(1);
+	memcpy(entry->blocks, blocks, CHUNK_WIDTH * CHUNK_WIDTH);
+	shard.entries.emplace(hash, entry);
+	return (entry);
+}
+
+void	ChunkLayerStore::release(Entry *entry)
+{
+	Shard &				shard = _shards[entry->hash % LAYER_STORE_SHARDS];
+	std::lock_guard<std::mutex>	lock(shard.mutex);
+
+	shard.layers--;
+	if (entry->refCount.fetch_sub(1, std::memory_order_relaxed) > 1)
+		return ;
+
+	auto	range = shard.entries.equal_range(entry->hash);
+
+	for (auto it = range.first; it != range.second; it++) {
+		if (it->second == entry) {
+			shard.entries.erase(it);
+			break ;
+		}
+	}
+	_pool.deallocate(entry);
+}
+
+ChunkLayerStoreStats	ChunkLayerStore::getStats()
+{
+	ChunkLayerStoreStats	stats = {0, 0, 0, 0};
+
+	for (Shard &shard : _shards) {
+		std::lock_guard<std::mutex>	lock(shard.mutex);
+
+		stats.layers += shard.layers;
+		stats.buffers += shard.entries.size();
+		stats.lookups += shard.lookups;
+		stats.hits += shard.hits;
+	}
+	return (stats);
+}
+
+void	ChunkLayerStore::printStats()
+{
+	ChunkLayerStoreStats	stats = getStats();
+
+	std::cout << "Interned layers: " << stats.layers << " layers sharing " << stats.buffers << " buffers";
+	if (stats.buffers)
+		std::cout << " (dedup ratio " << (float)stats.layers / stats.buffers << ", "
+			<< (stats.layers - stats.buffers) * CHUNK_WIDTH * CHUNK_WIDTH / 1024 << "KB saved)";
+	std::cout << ", " << stats.hits << "/" << stats.lookups << " lookups found a buffer" << std::endl;
+}
+/// ---
+
+//// ---
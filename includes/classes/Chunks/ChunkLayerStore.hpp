@@ -0,0 +1,55 @@
+# pragma once
+
+/// Defines
+# define LAYER_STORE_SHARDS	16 // Locks of the store, a layer goes to the shard of its hash
+
+/// System includes
+# include <atomic>
+# include <cstdint>
+# include <mutex>
+# include <unordered_map>
+
+/// Dependencies
+# include "AChunk.hpp"
+# include "SlabPool.hpp"
+
+typedef struct ChunkLayerStoreStats {
+	size_t		layers; // Layers using a shared buffer
+	size_t		buffers; // Distinct buffers they share
+	uint64_t	lookups; // Layers interned so far
+	uint64_t	hits; // Lookups that found an existing buffer
+} ChunkLayerStoreStats;
+
+// Interning store of the ChunkLayer blocks: the layers with the same blocks share a single buffer.
+// Buffers are found by a hash of their blocks, reference counted and freed with their last layer.
+// A shared buffer is read-only, a layer copies it to a buffer of its own before an edit (ChunkLayer::set).
+class	ChunkLayerStore {
+	public:
+		typedef struct Entry {
+			uint64_t		hash;
+			std::atomic<uint32_t>	refCount; // Only changed with its shard locked
+			uint8_t			blocks[CHUNK_WIDTH * CHUNK_WIDTH];
+		} Entry;
+
+	private:
+		typedef struct alignas(64) Shard {
+			std::mutex					mutex;
+			std::unordered_multimap<uint64_t, Entry *>	entries; // Hash -> buffers, collisions are compared
+			size_t						layers = 0;
+			uint64_t					lookups = 0;
+			uint64_t					hits = 0;
+		} Shard;
+
+		static Shard	_shards[LAYER_STORE_SHARDS];
+		static SlabPool	_pool;
+
+		static uint64_t	_hash(const uint8_t *blocks);
+
+	public:
+		// Shared buffer holding these CHUNK_WIDTH * CHUNK_WIDTH blocks, to give back with release
+		static Entry *	acquire(const uint8_t *blocks);
+		static void	release(Entry *entry);
+
+		static ChunkLayerStoreStats	getStats();
+		static void			printStats();
+};
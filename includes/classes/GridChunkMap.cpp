@@ -0,0 +1,203 @@
+# include <algorithm>
+
+# include "GridChunkMap.hpp"
+
+//// GridChunkMap class
+
+/// Constructors & Destructors
+GridChunkMap::GridChunkMap(const glm::ivec3 &dimensions)
+	: _dimensions(1 << _log2Ceil(dimensions.x), 1 << _log2Ceil(dimensions.y), 1 << _log2Ceil(dimensions.z)),
+	_shifts(_log2Ceil(dimensions.x), _log2Ceil(dimensions.y), _log2Ceil(dimensions.z)),
+	_cells((size_t)_dimensions.x * _dimensions.y * _dimensions.z), _used(_cells.size(), false), _size(0)
+{
+}
+
+GridChunkMap::~GridChunkMap()
+{
+}
+/// ---
+
+/// Private Methods
+
+int	GridChunkMap::_log2Ceil(const int &value)
+{
+	int	shift = 0;
+
+	while ((1 << shift) < value)
+		shift++;
+	return (shift);
+}
+
+// Wrap each coordinate into [0, dimension), the mask also wraps the negative positions
+size_t	GridChunkMap::_cellIndex(const glm::ivec3 &pos) const
+{
+	const size_t	x = pos.x & (_dimensions.x - 1);
+	const size_t	y = pos.y & (_dimensions.y - 1);
+	const size_t	z = pos.z & (_dimensions.z - 1);
+
+	return ((x << (_shifts.y + _shifts.z)) | (y << _shifts.z) | z);
+}
+
+size_t	GridChunkMap::_lockIndex(const size_t &cell)
+{
+	return (cell % GRID_CHUNK_MAP_LOCKS);
+}
+
+// The overflow entries of a position are only touched with its cell locked, so this stays true until it is unlocked
+bool	GridChunkMap::_inOverflow(const glm::ivec3 &pos)
+{
+	return (_overflow.size() && _overflow.find(pos, [](ChunkData &) {}));
+}
+/// ---
+
+/// Protected methods
+bool	GridChunkMap::_find(const glm::ivec3 &pos, const FindCallback &fn)
+{
+	const size_t			index = _cellIndex(pos);
+	std::lock_guard<std::mutex>	lock(_locks[_lockIndex(index)].mutex);
+	ChunkData &			cell = _cells[index];
+
+	if (_used[index] && cell.Wpos == pos) {
+		fn(cell);
+		return (true);
+	}
+	return (_overflow.size() && _overflow.find(pos, fn));
+}
+
+void	GridChunkMap::_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn)
+{
+	const size_t			index = _cellIndex(pos);
+	std::lock_guard<std::mutex>	lock(_locks[_lockIndex(index)].mutex);
+	ChunkData &			cell = _cells[index];
+
+	if (_used[index] && cell.Wpos == pos) {
+		fn(cell, false);
+		return ;
+	}
+
+	// Cell held by another position, or this one was already stored aside while it was
+	if (_used[index] || _inOverflow(pos)) {
+		_overflow.findOrInsert(pos, fn);
+		return ;
+	}
+
+	cell = ChunkData();
+	cell.Wpos = pos;
+	_used[index] = true;
+	if (!fn(cell, true)) {
+		cell = ChunkData();
+		_used[index] = false;
+		return ;
+	}
+	_size.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The locks are always taken in increasing order, then the overflow ones, so two neighbourhoods can not deadlock
+void	GridChunkMap::_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn)
+{
+	const glm::ivec3	positions[7] = {
+		pos,
+		{pos.x - 1, pos.y, pos.z}, {pos.x + 1, pos.y, pos.z}, // x axis
+		{pos.x, pos.y - 1, pos.z}, {pos.x, pos.y + 1, pos.z}, // y axis
+		{pos.x, pos.y, pos.z - 1}, {pos.x, pos.y, pos.z + 1}  // z axis
+	};
+	size_t		indices[7];
+	size_t		sorted[7];
+	ChunkData *	chunks[7];
+	bool		complete = true;
+
+	for (size_t i = 0; i < 7; i++) {
+		indices[i] = _cellIndex(positions[i]);
+		sorted[i] = _lockIndex(indices[i]);
+	}
+
+	std::sort(sorted, sorted + 7);
+	size_t	lockCount = std::unique(sorted, sorted + 7) - sorted;
+
+	for (size_t i = 0; i < lockCount; i++)
+		_locks[sorted[i]].mutex.lock();
+
+	for (size_t i = 0; i < 7; i++) {
+		ChunkData &	cell = _cells[indices[i]];
+
+		chunks[i] = (_used[indices[i]] && cell.Wpos == positions[i]) ? &cell : nullptr;
+		complete = complete && chunks[i];
+	}
+
+	// Look for the missing ones in the overflow, with its own locks held as well
+	if (complete || !_overflow.size())
+		fn(chunks[0], chunks + 1);
+	else {
+		_overflow.findNeightbourhood(pos, [&](ChunkData *chunk, ChunkData *neightbours[6]) {
+			if (!chunks[0])
+				chunks[0] = chunk;
+			for (size_t i = 0; i < 6; i++)
+				if (!chunks[i + 1])
+					chunks[i + 1] = neightbours[i];
+			fn(chunks[0], chunks + 1);
+		});
+	}
+
+	for (size_t i = lockCount; i > 0; i--)
+		_locks[sorted[i - 1]].mutex.unlock();
+}
+
+bool	GridChunkMap::_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred)
+{
+	const size_t			index = _cellIndex(pos);
+	std::lock_guard<std::mutex>	lock(_locks[_lockIndex(index)].mutex);
+	ChunkData &			cell = _cells[index];
+
+	if (!_used[index] || cell.Wpos != pos)
+		return (_overflow.size() && _overflow.eraseIf(pos, pred));
+
+	if (!pred(cell))
+		return (false);
+
+	cell = ChunkData();
+	_used[index] = false;
+	_size.fetch_sub(1, std::memory_order_relaxed);
+	return (true);
+}
+
+// The cells of a lock are one every GRID_CHUNK_MAP_LOCKS
+void	GridChunkMap::_forEach(const FindCallback &fn)
+{
+	for (size_t i = 0; i < GRID_CHUNK_MAP_LOCKS; i++) {
+		std::lock_guard<std::mutex>	lock(_locks[i].mutex);
+
+		for (size_t index = i; index < _cells.size(); index += GRID_CHUNK_MAP_LOCKS)
+			if (_used[index])
+				fn(_cells[index]);
+	}
+	_overflow.forEach(fn);
+}
+/// ---
+
+/// Public methods
+void	GridChunkMap::clear()
+{
+	for (size_t i = 0; i < GRID_CHUNK_MAP_LOCKS; i++) {
+		std::lock_guard<std::mutex>	lock(_locks[i].mutex);
+
+		for (size_t index = i; index < _cells.size(); index += GRID_CHUNK_MAP_LOCKS) {
+			_cells[index] = ChunkData();
+			_used[index] = false;
+		}
+	}
+	_size.store(0, std::memory_order_relaxed);
+	_overflow.clear();
+}
+
+size_t	GridChunkMap::size() const
+{
+	return (_size.load(std::memory_order_relaxed) + _overflow.size());
+}
+
+size_t	GridChunkMap::getOverflowCount() const
+{
+	return (_overflow.size());
+}
+/// ---
+
+//// ---
@@ -0,0 +1,63 @@
+# pragma once
+
+/// Defines
+# define GLM_ENABLE_EXPERIMENTAL
+# define GRID_CHUNK_MAP_LOCKS	61 // Prime, so a cell and its 6 neighbours rarely share a lock
+
+/// System includes
+# include <atomic>
+# include <cstdint>
+# include <mutex>
+# include <vector>
+
+/// Dependencies
+# include "glm/glm.hpp"
+# include "AChunkMap.hpp"
+# include "HashChunkMap.hpp"
+
+// Concurrent map of the loaded chunks stored in a 3D ring buffer, the cell of a chunk is Wpos mod dimensions.
+// The dimensions are rounded up to powers of 2 so the modulo is a mask.
+// Made for a bounded box of chunks following the camera: a lookup is a few masks, no hashing nor probing,
+// and a cell left behind by the camera is reused by the chunk entering on the opposite side.
+// Two positions of the same box never share a cell if it is no larger than the dimensions. When they do anyway
+// (an unload still pending while the camera moves on), the newcomer is stored in an overflow hash map.
+// The cells are guarded by GRID_CHUNK_MAP_LOCKS striped locks, the callbacks run with the lock of their cell held.
+class	GridChunkMap : public AChunkMap {
+	private:
+		typedef struct alignas(64) Lock {
+			std::mutex	mutex;
+		} Lock;
+
+		const glm::ivec3	_dimensions; // Powers of 2
+		const glm::ivec3	_shifts; // log2 of the dimensions
+		std::vector<ChunkData>	_cells;
+		std::vector<uint8_t>	_used; // Kept apart from the cells so walking the grid only touches the used ones
+		Lock			_locks[GRID_CHUNK_MAP_LOCKS];
+		HashChunkMap		_overflow; // Positions whose cell is held by another one, always locked after the cells
+		std::atomic<size_t>	_size; // Chunks in the cells
+
+		static int	_log2Ceil(const int &value);
+
+		size_t		_cellIndex(const glm::ivec3 &pos) const;
+		static size_t	_lockIndex(const size_t &cell);
+
+		// Must be called with the cell locked
+		bool	_inOverflow(const glm::ivec3 &pos);
+
+	protected:
+		bool	_find(const glm::ivec3 &pos, const FindCallback &fn) override;
+		void	_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn) override;
+		void	_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn) override;
+		bool	_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred) override;
+		void	_forEach(const FindCallback &fn) override;
+
+	public:
+		GridChunkMap(const glm::ivec3 &dimensions); // in chunks, at least the size of the loaded box
+		~GridChunkMap();
+
+		void	clear() override;
+		size_t	size() const override;
+
+		// Chunks that did not fit in their cell
+		size_t	getOverflowCount() const;
+};
@@ -0,0 +1,246 @@
+# include "HashChunkMap.hpp"
+
+//// HashChunkMap class
+
+/// Constructors & Destructors
+HashChunkMap::HashChunkMap() : _size(0)
+{
+}
+
+HashChunkMap::~HashChunkMap()
+{
+}
+/// ---
+
+/// Private Methods
+
+// 21 bits per coordinate
+uint64_t	HashChunkMap::_packPosition(const glm::ivec3 &pos)
+{
+	const uint64_t	mask = (1 << 21) - 1;
+
+	return (((uint64_t)pos.x & mask) << 42)
+		| (((uint64_t)pos.y & mask) << 21)
+		| ((uint64_t)pos.z & mask);
+}
+
+// splitmix64 finalizer, every bit of the key affects every bit of the hash
+// The high bits select the shard and the low bits the slot in it
+uint64_t	HashChunkMap::_hash(const uint64_t &key)
+{
+	uint64_t	hash = key;
+
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	return (hash ^ (hash >> 31));
+}
+
+size_t	HashChunkMap::_shardIndex(const uint64_t &hash)
+{
+	return (hash >> (64 - HASH_CHUNK_MAP_SHARD_BITS));
+}
+
+size_t	HashChunkMap::_findSlot(const Shard &shard, const uint64_t &key, const uint64_t &hash)
+{
+	if (!shard.count)
+		return (_notFound);
+
+	const size_t	mask = shard.keys.size() - 1;
+
+	for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+		if (shard.keys[slot] == key)
+			return (slot);
+		if (shard.keys[slot] == HASH_CHUNK_MAP_EMPTY_KEY)
+			return (_notFound);
+	}
+}
+
+// The key must not be in the shard yet, the value is left default constructed
+size_t	HashChunkMap::_insertSlot(Shard &shard, const uint64_t &key, const uint64_t &hash)
+{
+	// Keep the load factor under 3/4 so the probe sequences stay short
+	if ((shard.count + 1) * 4 > shard.keys.size() * 3)
+		_grow(shard);
+
+	const size_t	mask = shard.keys.size() - 1;
+	size_t		slot = hash & mask;
+
+	while (shard.keys[slot] != HASH_CHUNK_MAP_EMPTY_KEY)
+		slot = (slot + 1) & mask;
+
+	shard.keys[slot] = key;
+	shard.values[slot] = ChunkData();
+	shard.count++;
+	return (slot);
+}
+
+// Backward-shift deletion: the entries following the hole are moved back into it
+// when their home slot is not between the hole and their current slot
+void	HashChunkMap::_eraseSlot(Shard &shard, size_t slot)
+{
+	const size_t	mask = shard.keys.size() - 1;
+
+	for (size_t next = (slot + 1) & mask; shard.keys[next] != HASH_CHUNK_MAP_EMPTY_KEY; next = (next + 1) & mask) {
+		const size_t	home = _hash(shard.keys[next]) & mask;
+
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			shard.keys[slot] = shard.keys[next];
+			shard.values[slot] = shard.values[next];
+			slot = next;
+		}
+	}
+
+	shard.keys[slot] = HASH_CHUNK_MAP_EMPTY_KEY;
+	shard.values[slot] = ChunkData();
+	shard.count--;
+}
+
+void	HashChunkMap::_grow(Shard &shard)
+{
+	std::vector<uint64_t>	keys(std::max(shard.keys.size() * 2, (size_t)HASH_CHUNK_MAP_MIN_CAPACITY), HASH_CHUNK_MAP_EMPTY_KEY);
+	std::vector<ChunkData>	values(keys.size());
+	const size_t		mask = keys.size() - 1;
+
+	for (size_t i = 0; i < shard.keys.size(); i++) {
+		if (shard.keys[i] == HASH_CHUNK_MAP_EMPTY_KEY)
+			continue;
+
+		size_t	slot = _hash(shard.keys[i]) & mask;
+
+		while (keys[slot] != HASH_CHUNK_MAP_EMPTY_KEY)
+			slot = (slot + 1) & mask;
+		keys[slot] = shard.keys[i];
+		values[slot] = shard.values[i];
+	}
+
+	shard.keys.swap(keys);
+	shard.values.swap(values);
+}
+/// ---
+
+/// Protected methods
+bool	HashChunkMap::_find(const glm::ivec3 &pos, const FindCallback &fn)
+{
+	const uint64_t			key = _packPosition(pos);
+	const uint64_t			hash = _hash(key);
+	Shard &				shard = _shards[_shardIndex(hash)];
+	std::lock_guard<std::mutex>	lock(shard.mutex);
+	size_t				slot = _findSlot(shard, key, hash);
+
+	if (slot == _notFound)
+		return (false);
+
+	fn(shard.values[slot]);
+	return (true);
+}
+
+void	HashChunkMap::_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn)
+{
+	const uint64_t			key = _packPosition(pos);
+	const uint64_t			hash = _hash(key);
+	Shard &				shard = _shards[_shardIndex(hash)];
+	std::lock_guard<std::mutex>	lock(shard.mutex);
+	size_t				slot = _findSlot(shard, key, hash);
+	bool				inserted = slot == _notFound;
+
+	if (inserted) {
+		slot = _insertSlot(shard, key, hash);
+		shard.values[slot].Wpos = pos;
+	}
+
+	if (!fn(shard.values[slot], inserted) && inserted) {
+		_eraseSlot(shard, slot);
+		return ;
+	}
+	if (inserted)
+		_size.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The shards are always locked in increasing order, so two neighbourhoods can not deadlock
+void	HashChunkMap::_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn)
+{
+	const glm::ivec3	positions[7] = {
+		pos,
+		{pos.x - 1, pos.y, pos.z}, {pos.x + 1, pos.y, pos.z}, // x axis
+		{pos.x, pos.y - 1, pos.z}, {pos.x, pos.y + 1, pos.z}, // y axis
+		{pos.x, pos.y, pos.z - 1}, {pos.x, pos.y, pos.z + 1}  // z axis
+	};
+	uint64_t	keys[7];
+	uint64_t	hashes[7];
+	size_t		indices[7];
+	size_t		sorted[7];
+	ChunkData *	chunks[7];
+
+	for (size_t i = 0; i < 7; i++) {
+		keys[i] = _packPosition(positions[i]);
+		hashes[i] = _hash(keys[i]);
+		indices[i] = sorted[i] = _shardIndex(hashes[i]);
+	}
+
+	std::sort(sorted, sorted + 7);
+	size_t	lockCount = std::unique(sorted, sorted + 7) - sorted;
+
+	for (size_t i = 0; i < lockCount; i++)
+		_shards[sorted[i]].mutex.lock();
+
+	for (size_t i = 0; i < 7; i++) {
+		Shard &	shard = _shards[indices[i]];
+		size_t	slot = _findSlot(shard, keys[i], hashes[i]);
+
+		chunks[i] = (slot != _notFound) ? &shard.values[slot] : nullptr;
+	}
+
+	fn(chunks[0], chunks + 1);
+
+	for (size_t i = lockCount; i > 0; i--)
+		_shards[sorted[i - 1]].mutex.unlock();
+}
+
+bool	HashChunkMap::_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred)
+{
+	const uint64_t			key = _packPosition(pos);
+	const uint64_t			hash = _hash(key);
+	Shard &				shard = _shards[_shardIndex(hash)];
+	std::lock_guard<std::mutex>	lock(shard.mutex);
+	size_t				slot = _findSlot(shard, key, hash);
+
+	if (slot == _notFound || !pred(shard.values[slot]))
+		return (false);
+
+	_eraseSlot(shard, slot);
+	_size.fetch_sub(1, std::memory_order_relaxed);
+	return (true);
+}
+
+void	HashChunkMap::_forEach(const FindCallback &fn)
+{
+	for (Shard &shard : _shards) {
+		std::lock_guard<std::mutex>	lock(shard.mutex);
+
+		for (size_t i = 0; i < shard.keys.size(); i++)
+			if (shard.keys[i] != HASH_CHUNK_MAP_EMPTY_KEY)
+				fn(shard.values[i]);
+	}
+}
+/// ---
+
+/// Public methods
+void	HashChunkMap::clear()
+{
+	for (Shard &shard : _shards) {
+		std::lock_guard<std::mutex>	lock(shard.mutex);
+
+		shard.keys.clear();
+		shard.values.clear();
+		shard.count = 0;
+	}
+	_size.store(0, std::memory_order_relaxed);
+}
+
+size_t	HashChunkMap::size() const
+{
+	return (_size.load(std::memory_order_relaxed));
+}
+/// ---
+
+//// ---
@@ -0,0 +1,63 @@
+# pragma once
+
+/// Defines
+# define GLM_ENABLE_EXPERIMENTAL
+# define HASH_CHUNK_MAP_SHARD_BITS	6 // 2^bits independently locked shards
+# define HASH_CHUNK_MAP_MIN_CAPACITY	64 // Slots of a shard table when first used, must be a power of 2
+# define HASH_CHUNK_MAP_EMPTY_KEY	~(uint64_t)0 // Never produced by a packed position (63 bits)
+
+/// System includes
+# include <algorithm>
+# include <atomic>
+# include <cstdint>
+# include <mutex>
+# include <vector>
+
+/// Dependencies
+# include "glm/glm.hpp"
+# include "AChunkMap.hpp"
+
+// Concurrent hash map of the loaded chunks, works for any set of positions.
+// The positions are spread over independently locked shards, so threads working on different chunks rarely wait.
+// Each shard is a flat open-addressing table with linear probing, keyed by the position packed in 64 bits:
+// the keys are probed in their own array and deletions shift the following entries back instead of leaving tombstones.
+// The callbacks run with the shard of their entry locked.
+class	HashChunkMap : public AChunkMap {
+	private:
+		typedef struct alignas(64) Shard {
+			std::mutex		mutex;
+			std::vector<uint64_t>	keys; // HASH_CHUNK_MAP_EMPTY_KEY for free slots
+			std::vector<ChunkData>	values;
+			size_t			count = 0;
+		} Shard;
+
+		static const size_t	_shardCount = (size_t)1 << HASH_CHUNK_MAP_SHARD_BITS;
+		static const size_t	_notFound = ~(size_t)0;
+
+		Shard			_shards[_shardCount];
+		std::atomic<size_t>	_size;
+
+		static uint64_t	_packPosition(const glm::ivec3 &pos);
+		static uint64_t	_hash(const uint64_t &key);
+		static size_t	_shardIndex(const uint64_t &hash);
+
+		// Must be called with the shard locked
+		static size_t	_findSlot(const Shard &shard, const uint64_t &key, const uint64_t &hash);
+		static size_t	_insertSlot(Shard &shard, const uint64_t &key, const uint64_t &hash);
+		static void	_eraseSlot(Shard &shard, size_t slot);
+		static void	_grow(Shard &shard);
+
+	protected:
+		bool	_find(const glm::ivec3 &pos, const FindCallback &fn) override;
+		void	_findOrInsert(const glm::ivec3 &pos, const InsertCallback &fn) override;
+		void	_findNeightbourhood(const glm::ivec3 &pos, const NeightbourhoodCallback &fn) override;
+		bool	_eraseIf(const glm::ivec3 &pos, const PredicateCallback &pred) override;
+		void	_forEach(const FindCallback &fn) override;
+
+	public:
+		HashChunkMap();
+		~HashChunkMap();
+
+		void	clear() override;
+		size_t	size() const override;
+};
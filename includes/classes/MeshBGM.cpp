@@ -1,39 +1,36 @@
 # include <VoxelSystem.hpp>
+# include "BitMatrix.hpp"
 
-// Check if a neighbour chunk mesh is loaded
-static inline bool	isNeightbourLoaded(ChunkData *neightbour) {
-	return neightbour && neightbour->chunk && (neightbour->mesh || neightbour->inCreation);
+# define MESH_PLANE_SLOTS	256 // Block types meshed at once, every uint8_t block id
+
+// Binary planes of the block types of an axis, for both face directions.
+// Reused by every mesh of a worker: a type takes the next palette slot when it shows up and its planes are cleared then,
+// the active types are listed so only them are meshed and released, a mesh allocates nothing.
+typedef struct MeshPlanes {
+	uint32_t	planes[MESH_PLANE_SLOTS][2][CHUNK_WIDTH][CHUNK_WIDTH]; // By palette slot, then face direction
+	uint16_t	slots[256]; // Palette slot of each block id, MESH_PLANE_SLOTS if not active
+	uint8_t		ids[MESH_PLANE_SLOTS]; // Active block ids
+	size_t		count = 0;
+
+	MeshPlanes() { std::fill(slots, slots + 256, MESH_PLANE_SLOTS); }
+} MeshPlanes;
+
+// Block of the snapshot chunk, same coordinates as BLOCK_AT
+static inline uint8_t	blockAt(const MeshSnapshot &snapshot, const int &x, const int &y, const int &z) {
+	return snapshot.blocks[y][x * CHUNK_WIDTH + z];
 }
 
-// function to quickly count the number of trailing zeros in a 32-bit binary number representation
-static int	trailing_zeros32(uint64_t x)
+// Number of trailing zeros of the 32 low bits, 32 if they are all 0.
+// The bit 32 stops the count, so the builtin (tzcnt) is never given 0
+static inline int	trailing_zeros32(uint64_t x)
 {
-	int	n = 1;
-	
-	if (!x) return 32;
-	if ((x & 0x0000FFFF) == 0) {
-		n = n + 16;
-		x = x >> 16;
-	}
-	if ((x & 0x000000FF) == 0) {
-		n = n + 8;
-		x = x >> 8;
-	}
-	if ((x & 0x0000000F) == 0) {
-		n = n + 4;
-		x = x >> 4;
-	}
-	if ((x & 0x00000003) == 0) {
-		n = n + 2;
-		x = x >> 2;
-	}
-	return n - (x & 1);
+	return (__builtin_ctzll(x | ((uint64_t)1 << 32)));
 }
 
-// function to quickly count the number of trailing ones in a 32-bit binary number representation
-static int	trailing_ones32(uint64_t x)
+// Number of trailing ones of the 32 low bits
+static inline int	trailing_ones32(uint64_t x)
 {
-	return trailing_zeros32(~x);
+	return (trailing_zeros32(~x));
 }
 
 static uint64_t		binMap(const uint64_t &x, const uint64_t &count, const uint64_t &stride)
@@ -155,7 +152,7 @@ static void	binaryGreedyMeshing(std::vector<DATA_TYPE> *vertices, uint32_t plane
 			if (height % LOD != 0)
 				height += LOD - (height % LOD);
 
-			while (1 & (plane[i] >> (col + height)) && col + height < CHUNK_WIDTH)
+			while (col + height < CHUNK_WIDTH && 1 & (plane[i] >> (col + height)))
 				height += LOD;
 
 			int	width = LOD;
@@ -194,7 +191,35 @@ static void	binaryGreedyMeshing(std::vector<DATA_TYPE> *vertices, uint32_t plane
 	}
 }
 
-static void	constructXAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&xAxisBitmask)[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)], ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD)
+// Palette slot of the block id, a new active type gets cleared planes
+static uint16_t	activeSlot(MeshPlanes &planes, const uint8_t &id)
+{
+	uint16_t &	slot = planes.slots[id];
+
+	if (slot == MESH_PLANE_SLOTS) {
+		slot = planes.count;
+		planes.ids[planes.count++] = id;
+		memset(planes.planes[slot], 0, sizeof(planes.planes[slot]));
+	}
+	return (slot);
+}
+
+// Execute the binary greedy meshing algorythme on the planes of the active types, then release them.
+// The types are meshed by increasing block id, in the same order as before
+static void	meshActivePlanes(std::vector<DATA_TYPE> *vertices, MeshPlanes &planes, const uint8_t &axis, const uint8_t &LOD)
+{
+	std::sort(planes.ids, planes.ids + planes.count);
+	for (int i = 0; i < 2; i++)
+		for (size_t t = 0; t < planes.count; t++)
+			for (int j = 0; j < CHUNK_WIDTH; j += LOD)
+				binaryGreedyMeshing(vertices, planes.planes[planes.slots[planes.ids[t]]][i][j], j, planes.ids[t], axis + i, LOD);
+
+	for (size_t t = 0; t < planes.count; t++)
+		planes.slots[planes.ids[t]] = MESH_PLANE_SLOTS;
+	planes.count = 0;
+}
+
+static void	constructXAxisMesh(std::vector<DATA_TYPE> *vertices, MeshPlanes &planes, uint64_t (&xAxisBitmask)[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)], const MeshSnapshot &snapshot, const uint8_t &LOD)
 {
 	// Get the X axis neighbours data
 	for (uint64_t i = 0; i < CHUNK_HEIGHT * CHUNK_WIDTH; i++) {
@@ -202,13 +227,12 @@ static void	constructXAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&xAxi
 		uint64_t	z = i % CHUNK_WIDTH;
 
 		// Temporary fix for hole in the map (NEED TO FIND A BETTER SOLUTION)
-		// if (isNeightbourLoaded(neightboursChunks[4]) && BLOCK_AT(neightboursChunks[4]->chunk, CHUNK_WIDTH - 1, y, z))
+		// if (snapshot.neightbourLoaded[4] && snapshot.borders[4][y * CHUNK_WIDTH + z])
 		// 	xAxisBitmask[i] |= (uint64_t)0x1 << 0;
-		if (isNeightbourLoaded(neightboursChunks[5]) && BLOCK_AT(neightboursChunks[5]->chunk, 0, y, z))
+		if (snapshot.neightbourLoaded[5] && snapshot.borders[5][y * CHUNK_WIDTH + z])
 			xAxisBitmask[i] |= (uint64_t)0x1 << (CHUNK_WIDTH + 1);
 	}
 	
-	std::map<uint8_t, uint32_t[CHUNK_WIDTH][CHUNK_WIDTH]>	binaryPlaneHM[2];
 	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
 		// Culling facing forwardX
 		uint64_t	forwardXCol = xAxisBitmask[i] & ~(xAxisBitmask[i] >> 1);
@@ -220,36 +244,34 @@ static void	constructXAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&xAxi
 		backwardXCol = backwardXCol >> 1;
 		backwardXCol = backwardXCol & ~((uint64_t)1 << CHUNK_WIDTH);
 		
-		for (int j = 0; j < CHUNK_WIDTH; j++) {
-			uint8_t	id = BLOCK_AT(chunk.chunk, j, i / CHUNK_WIDTH, i % CHUNK_WIDTH);
-			
+		// Only the blocks with a face, one tzcnt per face instead of testing every bit
+		for (uint64_t faces = backwardXCol | forwardXCol; faces; faces &= faces - 1) {
+			int	j = trailing_zeros32(faces);
+			uint8_t	id = blockAt(snapshot, j, i / CHUNK_WIDTH, i % CHUNK_WIDTH);
+			uint16_t	slot = activeSlot(planes, id);
+
 			if (1 & (backwardXCol >> j))
-				binaryPlaneHM[0][id][j][i / CHUNK_WIDTH] |= (uint32_t)0x1 << (i % CHUNK_WIDTH);
+				planes.planes[slot][0][j][i / CHUNK_WIDTH] |= (uint32_t)0x1 << (i % CHUNK_WIDTH);
 
 			if (1 & (forwardXCol >> j))
-				binaryPlaneHM[1][id][j][i / CHUNK_WIDTH] |= (uint32_t)0x1 << (i % CHUNK_WIDTH);
+				planes.planes[slot][1][j][i / CHUNK_WIDTH] |= (uint32_t)0x1 << (i % CHUNK_WIDTH);
 		}
 	}
-	// Execute the binary greedy meshing algorythme for the X axis
-	for (int i = 0; i < 2; i++)
-		for (auto &[key, value] : binaryPlaneHM[i])
-			for (int j = 0; j < CHUNK_WIDTH; j += LOD)
-				binaryGreedyMeshing(vertices, value[j], j, key, i, LOD);
+	meshActivePlanes(vertices, planes, 0, LOD);
 }
 
-static void	constructYAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&yAxisBitmask)[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)], ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD)
+static void	constructYAxisMesh(std::vector<DATA_TYPE> *vertices, MeshPlanes &planes, uint64_t (&yAxisBitmask)[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)], const MeshSnapshot &snapshot, const uint8_t &LOD)
 {
 	// Get the Y axis neighbours data
 	for (uint64_t i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
 		uint64_t	x = i % CHUNK_WIDTH;
 		uint64_t	z = i / CHUNK_WIDTH;
-		if (isNeightbourLoaded(neightboursChunks[2]) && BLOCK_AT(neightboursChunks[2]->chunk, x, CHUNK_HEIGHT - 1, z))
+		if (snapshot.neightbourLoaded[2] && snapshot.borders[2][x * CHUNK_WIDTH + z])
 			yAxisBitmask[i] |= (uint64_t)0x1 << 0;
-		if (isNeightbourLoaded(neightboursChunks[3]) && BLOCK_AT(neightboursChunks[3]->chunk, x, 0, z))
+		if (snapshot.neightbourLoaded[3] && snapshot.borders[3][x * CHUNK_WIDTH + z])
 			yAxisBitmask[i] |= (uint64_t)0x1 << (CHUNK_HEIGHT + 1);
 	}
 
-	std::map<uint8_t, uint32_t[CHUNK_WIDTH][CHUNK_HEIGHT]>	binaryPlaneHM[2];
 	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
 		// Culling facing forwardX
 		uint64_t	forwardYCol = yAxisBitmask[i] & ~(yAxisBitmask[i] >> 1);
@@ -261,36 +283,34 @@ static void	constructYAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&yAxi
 		backwardYCol = backwardYCol >> 1;
 		backwardYCol = backwardYCol & ~((uint64_t)1 << CHUNK_WIDTH);
 
-		for (int j = 0; j < CHUNK_WIDTH; j++) {
-			uint8_t	id = BLOCK_AT(chunk.chunk, i % CHUNK_WIDTH, j, i / CHUNK_WIDTH);
+		// Only the blocks with a face, one tzcnt per face instead of testing every bit
+		for (uint64_t faces = backwardYCol | forwardYCol; faces; faces &= faces - 1) {
+			int	j = trailing_zeros32(faces);
+			uint8_t	id = blockAt(snapshot, i % CHUNK_WIDTH, j, i / CHUNK_WIDTH);
+			uint16_t	slot = activeSlot(planes, id);
 
 			if (1 & (backwardYCol >> j))
-				binaryPlaneHM[0][id][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
+				planes.planes[slot][0][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
 
 			if (1 & (forwardYCol >> j))
-				binaryPlaneHM[1][id][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
+				planes.planes[slot][1][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
 		}
 	}
-	// Execute the binary greedy meshing algorythme for the X axis
-	for (int i = 0; i < 2; i++)
-		for (auto &[key, value] : binaryPlaneHM[i])
-			for (int j = 0; j < CHUNK_WIDTH; j += LOD)
-				binaryGreedyMeshing(vertices, value[j], j, key, i + 2, LOD);
+	meshActivePlanes(vertices, planes, 2, LOD);
 }
 
-static void	constructZAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&zAxisBitmask)[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)], ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD)
+static void	constructZAxisMesh(std::vector<DATA_TYPE> *vertices, MeshPlanes &planes, uint64_t (&zAxisBitmask)[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)], const MeshSnapshot &snapshot, const uint8_t &LOD)
 {
 	// Get the Z axis neighbours data
 	for (uint64_t i = 0; i < CHUNK_HEIGHT * CHUNK_WIDTH; i++) {
 		uint64_t	x = i % CHUNK_WIDTH;
 		uint64_t	y = i / CHUNK_HEIGHT;
-		if (isNeightbourLoaded(neightboursChunks[0]) && BLOCK_AT(neightboursChunks[0]->chunk, x, y, CHUNK_WIDTH - 1))
+		if (snapshot.neightbourLoaded[0] && snapshot.borders[0][x * CHUNK_WIDTH + y])
 			zAxisBitmask[i] |= (uint64_t)0x1 << 0;
-		if (isNeightbourLoaded(neightboursChunks[1]) && BLOCK_AT(neightboursChunks[1]->chunk, x, y, 0))
+		if (snapshot.neightbourLoaded[1] && snapshot.borders[1][x * CHUNK_WIDTH + y])
 			zAxisBitmask[i] |= (uint64_t)0x1 << (CHUNK_WIDTH + 1);
 	}
 
-	std::map<uint8_t, uint32_t[CHUNK_WIDTH][CHUNK_HEIGHT]>	binaryPlaneHM[2];
 	for (int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++) {
 		// Culling facing forwardX
 		uint64_t	forwardZCol = zAxisBitmask[i] & ~(zAxisBitmask[i] >> 1);
@@ -302,44 +322,72 @@ static void	constructZAxisMesh(std::vector<DATA_TYPE> *vertices, uint64_t (&zAxi
 		backwardZCol = backwardZCol >> 1;
 		backwardZCol = backwardZCol & ~((uint64_t)1 << CHUNK_WIDTH);
 
-		for (int j = 0; j < CHUNK_WIDTH; j++) {
-			uint8_t	id = BLOCK_AT(chunk.chunk, i % CHUNK_WIDTH, i / CHUNK_WIDTH, j);
+		// Only the blocks with a face, one tzcnt per face instead of testing every bit
+		for (uint64_t faces = backwardZCol | forwardZCol; faces; faces &= faces - 1) {
+			int	j = trailing_zeros32(faces);
+			uint8_t	id = blockAt(snapshot, i % CHUNK_WIDTH, i / CHUNK_WIDTH, j);
+			uint16_t	slot = activeSlot(planes, id);
 
 			if (1 & (backwardZCol >> j))
-				binaryPlaneHM[0][id][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
+				planes.planes[slot][0][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
 
 			if (1 & (forwardZCol >> j))
-				binaryPlaneHM[1][id][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
+				planes.planes[slot][1][j][i / CHUNK_WIDTH] |= (uint64_t)0x1 << (i % CHUNK_WIDTH);
 		}
 	}
-	// Execute the binary greedy meshing algorythme for the X axis
-	for (int i = 0; i < 2; i++)
-		for (auto &[key, value] : binaryPlaneHM[i])
-			for (int j = 0; j < CHUNK_WIDTH; j += LOD)
-				binaryGreedyMeshing(vertices, value[j], j, key, i + 4, LOD);
+	meshActivePlanes(vertices, planes, 4, LOD);
 }
 
-void	VoxelSystem::_constructChunkMesh(std::vector<DATA_TYPE> *vertices, ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD) {
+void	VoxelSystem::_constructChunkMesh(std::vector<DATA_TYPE> *vertices, const MeshSnapshot &snapshot, const uint8_t &LOD) {
 	uint64_t	xAxisBitmask[(CHUNK_WIDTH + 2) * (CHUNK_HEIGHT + 2)] = {0};
 	uint64_t	yAxisBitmask[(CHUNK_WIDTH + 2) * (CHUNK_WIDTH + 2)] = {0};
 	uint64_t	zAxisBitmask[(CHUNK_WIDTH + 2) * (CHUNK_HEIGHT + 2)] = {0};
 
+	// Reused by every mesh of the worker, too big for the stack
+	static thread_local unique_ptr<MeshPlanes>	planes(new MeshPlanes);
+
 	// Set the bitmasks of all the axis
-	for (uint64_t y = 0; y < CHUNK_HEIGHT; y += LOD) {
-		for (uint64_t z = 0; z < CHUNK_WIDTH; z += LOD) {
-			for (uint64_t x = 0; x < CHUNK_WIDTH; x += LOD) {
-				// For each axis, write a bit to represent a solid block
-				if (BLOCK_AT(chunk.chunk, x, y, z) != 0) {
-					xAxisBitmask[y * CHUNK_HEIGHT + z] |= binMap(0x1, LOD, 1) << (x + 1);	// Bit-shift is offset by one to allow for neighbour data
-					yAxisBitmask[z * CHUNK_WIDTH + x] |= binMap(0x1, LOD, 1) << (y + 1);	// Bit-shift is offset by one to allow for neighbour data
-					zAxisBitmask[y * CHUNK_HEIGHT + x] |= binMap(0x1, LOD, 1) << (z + 1);	// Bit-shift is offset by one to allow for neighbour data
+	if (LOD == 1) {
+		// Ready-made columns of the chunk along z, the ones along x and y are the same bits transposed
+		uint32_t	columns[CHUNK_WIDTH];
+
+		for (uint64_t i = 0; i < CHUNK_WIDTH * CHUNK_HEIGHT; i++)
+			zAxisBitmask[i] = (uint64_t)snapshot.occupancy[i] << 1;	// Bit-shift is offset by one to allow for neighbour data
+
+		// Bit x of [y * CHUNK_WIDTH + z] is bit z of [y * CHUNK_WIDTH + x]
+		for (uint64_t y = 0; y < CHUNK_HEIGHT; y++) {
+			memcpy(columns, snapshot.occupancy + y * CHUNK_WIDTH, sizeof(columns));
+			BitMatrix::transpose32(columns);
+			for (uint64_t z = 0; z < CHUNK_WIDTH; z++)
+				xAxisBitmask[y * CHUNK_HEIGHT + z] = (uint64_t)columns[z] << 1;
+		}
+
+		// Bit y of [z * CHUNK_WIDTH + x] is bit z of [y * CHUNK_WIDTH + x]
+		for (uint64_t x = 0; x < CHUNK_WIDTH; x++) {
+			for (uint64_t y = 0; y < CHUNK_HEIGHT; y++)
+				columns[y] = snapshot.occupancy[y * CHUNK_WIDTH + x];
+			BitMatrix::transpose32(columns);
+			for (uint64_t z = 0; z < CHUNK_WIDTH; z++)
+				yAxisBitmask[z * CHUNK_WIDTH + x] = (uint64_t)columns[z] << 1;
+		}
+	}
+	else {
+		for (uint64_t y = 0; y < CHUNK_HEIGHT; y += LOD) {
+			for (uint64_t z = 0; z < CHUNK_WIDTH; z += LOD) {
+				for (uint64_t x = 0; x < CHUNK_WIDTH; x += LOD) {
+					// For each axis, write a bit to represent a solid block
+					if (blockAt(snapshot, x, y, z) != 0) {
+						xAxisBitmask[y * CHUNK_HEIGHT + z] |= binMap(0x1, LOD, 1) << (x + 1);	// Bit-shift is offset by one to allow for neighbour data
+						yAxisBitmask[z * CHUNK_WIDTH + x] |= binMap(0x1, LOD, 1) << (y + 1);	// Bit-shift is offset by one to allow for neighbour data
+						zAxisBitmask[y * CHUNK_HEIGHT + x] |= binMap(0x1, LOD, 1) << (z + 1);	// Bit-shift is offset by one to allow for neighbour data
+					}
 				}
 			}
 		}
 	}
 
-	constructXAxisMesh(vertices, xAxisBitmask, chunk, neightboursChunks, LOD);
-	constructYAxisMesh(vertices, yAxisBitmask, chunk, neightboursChunks, LOD);
-	constructZAxisMesh(vertices, zAxisBitmask, chunk, neightboursChunks, LOD);
+	constructXAxisMesh(vertices, *planes, xAxisBitmask, snapshot, LOD);
+	constructYAxisMesh(vertices, *planes, yAxisBitmask, snapshot, LOD);
+	constructZAxisMesh(vertices, *planes, zAxisBitmask, snapshot, LOD);
 
 }
@@ -2,114 +2,142 @@
 
 /// Private functions
 
-// Mesh Generation thread routine
-void	VoxelSystem::_meshGenerationRoutine() {
-	if (VERBOSE)
-		cout << "> Mesh Generation thread started" << endl;
-
-	while (!_quitting) {
+// Check if a neighbour chunk mesh is loaded
+static inline bool	isNeightbourLoaded(ChunkData *neightbour) {
+	return neightbour && neightbour->chunk && (neightbour->mesh || neightbour->inCreation);
+}
 
-		// Check if there are meshes to generate, sleep if not
-		if (!_requestedMeshes.size() || !_requestedMeshesMutex.try_lock()) {
-			this_thread::sleep_for(chrono::milliseconds(THREAD_SLEEP_DURATION));
-			continue;
-		}
+// Mesh Generation job, executes one request of the queue
+// The chunk and its neighbours are only locked to take a snapshot and to store the result,
+// so several workers can build meshes at the same time
+void	VoxelSystem::_meshGenerationJob() {
+	// Reused by every job of the worker, the snapshot is too big for the stack
+	static thread_local unique_ptr<MeshSnapshot>	snapshot(new MeshSnapshot);
+	static thread_local vector<DATA_TYPE>		vertices;
+	ChunkRequest					request;
+	RequestTicket					ticket;
+
+	// Each job is submitted once its request is queued and takes the most urgent one
+	if (!_requestedMeshes.pop(request, ticket))
+		return;
 
-		deque<ChunkRequest> localRequestedMeshes = _requestedMeshes;
-		_requestedMeshesMutex.unlock();
+	bool	needMeshing = false;
 
-		// Generate meshes up to the batch limit
-		size_t batchCount = 0;
-		_chunksMutex.lock();
-		_meshToDeleteMutex.lock();
+	_chunks->findNeightbourhood(request.first, [&](ChunkData *chunk, ChunkData *neightboursChunks[6]) {
+		needMeshing = _prepareMesh(request, chunk, neightboursChunks, *snapshot);
+	});
 
-		for (ChunkRequest request : localRequestedMeshes) {
-			if (batchCount >= MESH_BATCH_LIMIT)
-				break;
+	if (needMeshing) {
+		if (!vertices.capacity())
+			vertices.reserve((pow(CHUNK_SIZE, 3) / 2) * 6);
+		vertices.clear();
+		snapshot->ticket = ticket;
+		_constructChunkMesh(&vertices, *snapshot, snapshot->LOD);
 
-			batchCount++;
+		ChunkMesh *	mesh = new ChunkMesh(vertices);
 
-			ivec3	Wpos = request.first;
-			if (_chunks.find(Wpos) == _chunks.end())
-				continue;
+		_chunks->findNeightbourhood(snapshot->Wpos, [&](ChunkData *chunk, ChunkData *neightboursChunks[6]) {
+			_commitMesh(*snapshot, mesh, chunk, neightboursChunks);
+		});
+	}
 
-			// Calculate the LOD of the chunk (cause crashes for now)
-			_chunks[Wpos].LOD = 1; // TODO: implement LOD
+	_requestedMeshes.release(request.first, ticket);
+}
 
-			ChunkData &data = _chunks[Wpos];
+// Execute the requested action, fill the snapshot and return true if a mesh has to be built
+// Called with the chunk and its neighbours locked
+bool	VoxelSystem::_prepareMesh(const ChunkRequest &request, ChunkData *chunk, ChunkData *neightboursChunks[6], MeshSnapshot &snapshot) {
+	if (!chunk)
+		return false;
 
-			// Search for neightbouring chunks
-			const ivec3	neightboursPos[6] = { 
-				{Wpos.x - 1, Wpos.y, Wpos.z}, {Wpos.x + 1, Wpos.y, Wpos.z}, // x axis
-				{Wpos.x, Wpos.y - 1, Wpos.z}, {Wpos.x, Wpos.y + 1, Wpos.z}, // y axis
-				{Wpos.x, Wpos.y, Wpos.z - 1}, {Wpos.x, Wpos.y, Wpos.z + 1}  // z axis
-			};
+	ChunkData &	data = *chunk;
 
-			ChunkData	*neightboursChunks[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+	data.LOD = 1; // TODO: implement LOD
 
-			for (size_t i = 0; i < 6; i++) {
-				// Check if the chunk exist and have data to work with
-				if (_chunks.find(neightboursPos[i]) != _chunks.end())
-					neightboursChunks[i] = &_chunks[neightboursPos[i]];
-			}
+	if (request.second == ChunkAction::DELETE) {
+		_meshToDeleteMutex.lock();
+		_deleteMesh(data, neightboursChunks);
+		if (!data.chunk)
+			_chunksToErase.push_back(data.Wpos);
+		data.inCreation = false;
+		_meshToDeleteMutex.unlock();
+		return false;
+	}
 
+	// Nothing to build for a completely empty chunk
+	if (!data.chunk || (IS_CHUNK_COMPRESSED(data.chunk) && !BLOCK_AT(data.chunk, 0, 0, 0))) {
+		_meshToDeleteMutex.lock();
+		if (data.mesh)
+			_deleteMesh(data, neightboursChunks);
+		data.neigthbourUpdated = false;
+		data.inCreation = false;
+		_meshToDeleteMutex.unlock();
+		return false;
+	}
 
-			// Execute the requested action on the chunk mesh
-			switch (request.second) {
-				case ChunkAction::CREATE_UPDATE:
-					_generateMesh(data, neightboursChunks, data.LOD);
-					break;
+	_takeMeshSnapshot(snapshot, data, neightboursChunks);
+	return true;
+}
 
-				case ChunkAction::DELETE:
-					_deleteMesh(data, neightboursChunks);
-					break;
-			}
+// Copy the blocks of the chunk and the facing layer of its neighbours
+void	VoxelSystem::_takeMeshSnapshot(MeshSnapshot &snapshot, ChunkData &chunk, ChunkData *neightboursChunks[6]) {
+	snapshot.Wpos = chunk.Wpos;
+	snapshot.LOD = chunk.LOD;
+	snapshot.version = chunk.version;
 
-			data.inCreation = false;
-		}
+	for (int y = 0; y < CHUNK_HEIGHT; y++)
+		chunk.chunk->getLayer(y, snapshot.blocks[y]);
+	memcpy(snapshot.occupancy, chunk.chunk->getOccupancy(), sizeof(snapshot.occupancy));
 
-		_meshToDeleteMutex.unlock();
-		_chunksMutex.unlock();
+	for (int i = 0; i < 6; i++) {
+		snapshot.neightbourLoaded[i] = isNeightbourLoaded(neightboursChunks[i]);
+		if (!snapshot.neightbourLoaded[i])
+			continue;
 
+		AChunk *	neightbour = neightboursChunks[i]->chunk;
+		const int	border = (i % 2) ? 0 : CHUNK_WIDTH - 1; // Layer touching the chunk
 
-		// Remove the generated meshes from the requested list
-		_requestedMeshesMutex.lock();
-		_requestedMeshes.erase(_requestedMeshes.begin(), _requestedMeshes.begin() + batchCount);
-		_requestedMeshesMutex.unlock();
+		// Same indexing as BLOCK_AT(neightbour, a, b, border) for x and BLOCK_AT(neightbour, border, a, b) for z
+		for (int a = 0; a < CHUNK_WIDTH; a++) {
+			if (i < 2)
+				neightbour->getColumn(a, border, &snapshot.borders[i][a * CHUNK_WIDTH]);
+			else if (i >= 4)
+				neightbour->getRow(border, a, &snapshot.borders[i][a * CHUNK_WIDTH]);
+		}
+		if (i == 2 || i == 3)
+			neightbour->getLayer(border, snapshot.borders[i]);
 	}
-
-	if (VERBOSE)
-		cout << "Mesh Generation thread stopped" << endl;
 }
 
-// Create/update the mesh of the given chunk
-// The data will be stored in the main thread at the end of OpenGL buffers
-void	VoxelSystem::_generateMesh(ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD) {
-	// Check if the chunk already have a mesh (in case of update)
-	if (chunk.mesh)
-		_deleteMesh(chunk, neightboursChunks);
+// Store the built mesh, unless the chunk changed or was requested again since the snapshot was taken
+// Called with the chunk and its neighbours locked
+void	VoxelSystem::_commitMesh(const MeshSnapshot &snapshot, ChunkMesh *mesh, ChunkData *chunk, ChunkData *neightboursChunks[6]) {
+	bool	stale = _requestedMeshes.isStale(snapshot.Wpos, snapshot.ticket);
 
-	chunk.neigthbourUpdated = false;
+	_meshToDeleteMutex.lock();
 
-	// Check if the chunk completely empty
-	if (!chunk.chunk || (IS_CHUNK_COMPRESSED(chunk.chunk) && !BLOCK_AT(chunk.chunk, 0, 0, 0)))
+	// Outdated, a newer request is already queued. The mesh is deleted by the main thread
+	if (stale || !chunk || chunk->version != snapshot.version || !chunk->chunk) {
+		_meshToDelete.push_back(mesh);
+		_meshToDeleteMutex.unlock();
 		return;
+	}
 
-	vector<DATA_TYPE>	vertices;
-	size_t		maxDataSizePerChunk = (pow(CHUNK_SIZE, 3) / 2) * 6 * sizeof(DATA_TYPE);
+	ChunkData &	data = *chunk;
 
-	vertices.reserve(maxDataSizePerChunk);
+	// Check if the chunk already have a mesh (in case of update)
+	if (data.mesh)
+		_deleteMesh(data, neightboursChunks);
 
-	_constructChunkMesh(&vertices, chunk, neightboursChunks, LOD);
+	data.neigthbourUpdated = false;
+	data.mesh = mesh;
+	data.inCreation = false;
 
-	_chunks[chunk.Wpos].mesh = new ChunkMesh(vertices);
+	_meshToDeleteMutex.unlock();
 }
 
 // Delete the first mesh
 void	VoxelSystem::_deleteMesh(ChunkData &chunk, ChunkData *neightboursChunks[6]) {
-	if (!_chunks.count(chunk.Wpos) || !chunk.mesh)
-		return;
-
 	if (!chunk.mesh)
 		return ;
 
@@ -141,17 +169,10 @@ void	VoxelSystem::_deleteMesh(ChunkData &chunk, ChunkData *neightboursChunks[6])
 //  - CREATE_UPDATE will generate or update the chunk mesh
 //  - DELETE will delete the mesh
 void	VoxelSystem::requestMesh(const vector<ChunkRequest> &requests) {
-	if (!requests.size())
-		return;
-
-	_requestedMeshesMutex.lock();
-
-	for (ChunkRequest req : requests) {
-		// Check if the request already exists
-		if (find(_requestedMeshes.begin(), _requestedMeshes.end(), req) == _requestedMeshes.end())
-			_requestedMeshes.push_back(req);
-	}
+	// Requests already waiting are collapsed by the queue, one job per queued request
+	size_t	queued = _requestedMeshes.push(requests);
 
-	_requestedMeshesMutex.unlock();
+	for (size_t i = 0; i < queued; i++)
+		_jobSystem->submit([this]() { _meshGenerationJob(); });
 }
 /// ---
@@ -28,6 +28,12 @@ VoxelSystem::VoxelSystem(const uint64_t &seed, Camera &camera) : _camera(camera)
 	// Initialize the rendering pipeline
 	_initDefferedRenderingPipeline();
 
+	// Store the chunks in a ring buffer around the camera, or in a hash map
+	if (GRID_CHUNK_MAP)
+		_chunks = new GridChunkMap(ivec3{HORIZONTAL_RENDER_DISTANCE, VERTICAL_RENDER_DISTANCE, HORIZONTAL_RENDER_DISTANCE} * 2 + UNLOAD_DISTANCE_MARGIN * 2 + 1);
+	else
+		_chunks = new HashChunkMap();
+
 	// Initialize the threads
 	_initThreads();
 
@@ -52,19 +58,35 @@ VoxelSystem::~VoxelSystem() {
 	if (_textureAtlas)
 		glDeleteTextures(1, &_textureAtlas);
 
-	// waiting for threads to finish
-	_quitting = true;
-	for (uint32_t i = 0; i < _cpuCoreCount / CHUNKGEN_CORE_RATIO; i++)
-		_chunkGenerationThreads[i].join();
-	_meshGenerationThread.join();
+	// Wait for the running jobs to finish, the queued ones are dropped
+	_jobSystem->stop();
+	if (VERBOSE)
+		_jobSystem->printStats();
+	delete _jobSystem;
 
-	// Delete all chunks
-	for (const ChunkMap::value_type &chunk : _chunks)
-		if (chunk.second.chunk)
-			delete chunk.second.chunk;
+	// Before the chunks are deleted, while the layers still share their buffers
+	if (VERBOSE && INTERN_LAYERS)
+		ChunkLayerStore::printStats();
 
-	_chunks.clear();
+	// Delete all chunks
+	_chunks->forEach([](ChunkData &data) {
+		if (data.chunk)
+			ChunkHandler::releaseChunk(data.chunk);
+	});
+
+	if (VERBOSE && GRID_CHUNK_MAP)
+		cout << "Chunks stored outside of the grid: " << dynamic_cast<GridChunkMap *>(_chunks)->getOverflowCount() << endl;
+	delete _chunks;
 	g_pendingFeatures.clear();
+	ChunkColumnCache::clear();
+
+	if (VERBOSE)
+		cout << "Recompaction: " << _recompactionStats.layers << " layers and " << _recompactionStats.chunks
+			<< " chunks compressed back, " << _recompactionStats.reclaimed / 1024 << "KB reclaimed" << endl;
+
+	// Every chunk is freed by now, the blocks still in use are idle in the thread caches
+	if (VERBOSE)
+		SlabPool::printStats();
 
 	if (VERBOSE)
 		cout << "VoxelSystem destroyed\n";
@@ -75,33 +97,17 @@ VoxelSystem::~VoxelSystem() {
 
 /// Private functions
 
-// Generate chunks around the spawn location in a 3 or less chunk radius
-void	VoxelSystem::_genWorldSpawn() {
-	vector<ChunkRequest>	spawnChunks;
-	const int		horizontalSpawnSize = glm::min(SPAWN_LOCATION_SIZE, HORIZONTAL_RENDER_DISTANCE);
-
-	for (int i = VERTICAL_RENDER_DISTANCE; i >= -VERTICAL_RENDER_DISTANCE; i--)
-		for (int j = -horizontalSpawnSize; j <= horizontalSpawnSize; j++)
-			for (int k = -horizontalSpawnSize; k <= horizontalSpawnSize; k++)
-				spawnChunks.push_back({{k, i, j}, ChunkAction::CREATE_UPDATE});
-	requestChunk(spawnChunks);
-}
-
 // Will initialize and start all the multi-threading related systems
 void	VoxelSystem::_initThreads() {
 	// Get the CPU core count of the system
 	_cpuCoreCount = std::thread::hardware_concurrency();
 
-	if (VERBOSE)
-		cout << "System has: " << _cpuCoreCount << " CPU cores available.\n Allocating: " << _cpuCoreCount / CHUNKGEN_CORE_RATIO << " for chunk generation" << endl;
+	uint32_t	workerCount = (_cpuCoreCount > RESERVED_CORES) ? _cpuCoreCount - RESERVED_CORES : 1;
 
-	// Allocate and start chunk generation threads
-	_chunkGenerationThreads = new thread[_cpuCoreCount / CHUNKGEN_CORE_RATIO];
-	for (uint32_t i = 0; i < _cpuCoreCount / CHUNKGEN_CORE_RATIO; i++)
-		_chunkGenerationThreads[i] = thread(&VoxelSystem::_chunkGenerationRoutine, this);
+	if (VERBOSE)
+		cout << "System has: " << _cpuCoreCount << " CPU cores available.\n Allocating: " << workerCount << " job workers for chunk and mesh generation" << endl;
 
-	// Start mesh generation thread
-	_meshGenerationThread = thread(&VoxelSystem::_meshGenerationRoutine, this);
+	_jobSystem = new JobSystem(workerCount);
 }
 
 // Will create and setup all the framebuffer and render texture necessary for rendering
@@ -212,7 +218,9 @@ void VoxelSystem::tryDestroyBlock()
 	vec3 worldCamPos = toVoxelCoords(camInfo.position);
 	vec3 currentPos = toVoxelCoords(camInfo.position);
 	vec3 lookAt = toVoxelCoords(camInfo.lookAt);
-	
+
+	bool	done = false;
+
 	do
 	{
 		// Get the chunk at the current position
@@ -221,12 +229,6 @@ void VoxelSystem::tryDestroyBlock()
 			floor(currentPos.y / (float)CHUNK_SIZE),
 			floor(currentPos.z / (float)CHUNK_SIZE)
 		};
-		ChunkMap::iterator it = _chunks.find(chunkPos);
-		if (it == _chunks.end())
-			return ;
-		ChunkData &chunkData = it->second;
-		if (!chunkData.chunk || !chunkData.mesh)
-			return ;
 
 		// Get the position of the current block in the chunk
 		ivec3 localPos = {
@@ -235,17 +237,26 @@ void VoxelSystem::tryDestroyBlock()
 			(int)mod(currentPos.x, (float)CHUNK_SIZE)
 		};
 
-		// Check if there is a block at the current position
-		uint8_t blockID = BLOCK_AT(chunkData.chunk, localPos.x, localPos.y, localPos.z);
-		if (blockID) {
-			ChunkHandler::setBlock(chunkData.chunk, localPos, 0);
-			requestMesh({{chunkPos, ChunkAction::CREATE_UPDATE}});
+		bool found = _chunks->find(chunkPos, [&](ChunkData &chunkData) {
+			if (!chunkData.chunk || !chunkData.mesh) {
+				done = true;
+				return ;
+			}
 
-			if (VERBOSE)
-				cout << BGreen << "Block destroyed at " << (int)currentPos.x << ", " << (int)currentPos.y << ", " << (int)currentPos.z << ResetColor << endl;
+			// Check if there is a block at the current position
+			if (chunkData.chunk->isSolid(localPos.x, localPos.y, localPos.z)) {
+				ChunkHandler::setBlock(chunkData.chunk, localPos, 0);
+				chunkData.version++;
+				_editedChunks.push_back({chunkPos, chunkData.version, chrono::steady_clock::now()});
+				requestMesh({{chunkPos, ChunkAction::CREATE_UPDATE}});
+				done = true;
 
+				if (VERBOSE)
+					cout << BGreen << "Block destroyed at " << (int)currentPos.x << ", " << (int)currentPos.y << ", " << (int)currentPos.z << ResetColor << endl;
+			}
+		});
+		if (!found || done)
 			return ;
-		}
 
 		// Move to the next position in the direction of the lookAt vector
 		currentPos -= glm::normalize(worldCamPos - lookAt) * 0.1f;
@@ -256,27 +267,25 @@ void VoxelSystem::tryDestroyBlock()
 		cout << BRed << "No block found" << ResetColor << endl;
 }
 
-static inline const vec4	extractPlane(const mat4& m, int row, int sign) {
-	vec4	plane = {
-		m[0][3] + sign * m[0][row],
-		m[1][3] + sign * m[1][row],
-		m[2][3] + sign * m[2][row],
-		m[3][3] + sign * m[3][row]
-	};
-	
-	float	len = length(vec3(plane)); // normalize by xyz length
-	return plane / len;
-}
-
 // Draw all chunks using batched rendering
 const GeoFrameBuffers	&VoxelSystem::draw(ShaderHandler &shader) {
-	if (_meshToDelete.size() &&  _meshToDeleteMutex.try_lock()) {
-		for (ChunkMesh *mesh : _meshToDelete)
-			delete mesh;
-		_meshToDelete.clear();
+	// Take the lists out first, the workers lock _meshToDeleteMutex with chunks locked
+	list<ChunkMesh *>	meshToDelete;
+	list<ivec3>		chunksToErase;
+
+	if ((_meshToDelete.size() || _chunksToErase.size()) && _meshToDeleteMutex.try_lock()) {
+		meshToDelete.swap(_meshToDelete);
+		chunksToErase.swap(_chunksToErase);
 		_meshToDeleteMutex.unlock();
 	}
 
+	for (ChunkMesh *mesh : meshToDelete)
+		delete mesh;
+
+	// Remove the unloaded chunks from the ChunkMap, unless they have been requested again since
+	for (const ivec3 &pos : chunksToErase)
+		_chunks->eraseIf(pos, [](ChunkData &data) { return !data.chunk && !data.mesh; });
+
 	// Bind the gBuffer
 	glBindFramebuffer(GL_FRAMEBUFFER, _gBuffer.gBuffer);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -286,42 +295,32 @@ const GeoFrameBuffers	&VoxelSystem::draw(ShaderHandler &shader) {
 	glBindTexture(GL_TEXTURE_2D, _textureAtlas);
 
 	// Setup frustum culling
-	mat4 VP = _camera; // Get the View-Projection matrix
-
-	array<vec4, 6> frustumPlanes;
-	frustumPlanes[0] = extractPlane(VP, 0, +1); // Left
-	frustumPlanes[1] = extractPlane(VP, 0, -1); // Right
-	frustumPlanes[2] = extractPlane(VP, 1, +1); // Bottom
-	frustumPlanes[3] = extractPlane(VP, 1, -1); // Top
-	frustumPlanes[4] = extractPlane(VP, 2, +1); // Near
-	frustumPlanes[5] = extractPlane(VP, 2, -1); // Far
+	const Frustum	frustum = _camera.getFrustum();
 
-	for (ChunkMap::iterator it = _chunks.begin(); it != _chunks.end(); it++) {
-		if (!it->second.mesh)
-			continue ;
+	// Collect the visible meshes, the shards are not kept locked while drawing
+	// The meshes are only deleted by the main thread, so they stay valid until the next frame
+	_drawList.clear();
+	_chunks->forEach([&](ChunkData &data) {
+		if (!data.mesh)
+			return ;
 
 		// Frustum culling
-		vec3 chunkCenter = vec3(it->first * CHUNK_SIZE + CHUNK_SIZE / 2);
+		vec3 chunkCenter = vec3(data.Wpos * CHUNK_SIZE + CHUNK_SIZE / 2);
 		float chunkRadius = CHUNK_SIZE * sqrt(3) / 2.0f;
 
-		bool inFrustrum = true;
-		for (auto& plane : frustumPlanes) {
-			float distance = dot(vec3(plane), chunkCenter) + plane.w;
-			if (distance < -chunkRadius) { // sphere outside
-				inFrustrum = false;
-				break;
-			}
-		}
-		if (!inFrustrum) continue;
+		if (Camera::isSphereInFrustum(frustum, chunkCenter, chunkRadius))
+			_drawList.push_back({data.Wpos, data.mesh});
+	});
 
+	for (const pair<ivec3, ChunkMesh *> &chunk : _drawList) {
 		// Draw the chunk
-		if (!it->second.mesh->getVAO())
-			it->second.mesh->updateMesh();
+		if (!chunk.second->getVAO())
+			chunk.second->updateMesh();
 
-		vec3	wPos = it->second.Wpos;
+		vec3	wPos = chunk.first;
 		shader.setUniform((*shader[1])->getID(), "worldPos", wPos);
 
-		it->second.mesh->draw();
+		chunk.second->draw();
 	}
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -354,4 +353,11 @@ size_t	VoxelSystem::getMeshRequestCount()
 	return _requestedMeshes.size();
 }
 
+RecompactionStats	VoxelSystem::getRecompactionStats()
+{
+	lock_guard<mutex>	lock(_recompactionMutex);
+
+	return _recompactionStats;
+}
+
 /// ---
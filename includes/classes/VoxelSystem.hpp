@@ -6,14 +6,14 @@
 # define CHUNK_SIZE 32
 # define HORIZONTAL_RENDER_DISTANCE 8
 # define VERTICAL_RENDER_DISTANCE 8
-# define SPAWN_LOCATION_SIZE	3
-# define MESH_BATCH_LIMIT (size_t)2048
-# define CHUNK_BATCH_LIMIT (size_t)128
-# define THREAD_SLEEP_DURATION 10 // in ms
-# define CHUNKGEN_CORE_RATIO	2
+# define UNLOAD_DISTANCE_MARGIN	2 // in chunks, gap between the load and unload rings
+# define REPRIORITIZE_VIEW_COS	0.96f // Cosine of the camera rotation that re-scores the queued requests (~16 degrees)
+# define RESERVED_CORES	1 // Cores left to the main thread, the others run the job system
 # define MIN_LOD (size_t)4
 # define MAX_LOD (size_t)1
 # define PLAYER_REACH 8 // in blocks
+# define RECOMPACTION_DELAY	2000 // in ms, since the last edit of a chunk before its uniform layers are compressed back
+# define RECOMPACTION_BATCH	16 // Chunks recompacted by a job, at most one job per update
 
 /// System includes
 # include <iostream>
@@ -23,6 +23,8 @@
 # include <deque>
 # include <thread>
 # include <mutex>
+# include <memory>
+# include <chrono>
 
 /// Dependencies
 # include <glad/glad.h>
@@ -30,9 +32,16 @@
 # include "Camera.hpp"
 # include <Shader.hpp>
 # include "chunk.h"
+# include "ChunkRequestQueue.hpp"
+# include "HashChunkMap.hpp"
+# include "GridChunkMap.hpp"
+# include "JobSystem.hpp"
+# include "SlabPool.hpp"
 
 /// Global variables
 extern bool VERBOSE;
+extern bool GRID_CHUNK_MAP;
+extern bool INTERN_LAYERS;
 
 using namespace std;
 using namespace glm;
@@ -45,49 +54,56 @@ typedef struct GeoFrameBuffers {
 	GLuint	gColor;
 } GeoFrameBuffers;
 
-typedef struct ChunkData {
-	ChunkMesh *	mesh;
-	AChunk *	chunk;
+// Copy of everything a mesh depends on, taken with the ChunkMap locked so the mesh can be built without it
+typedef struct MeshSnapshot {
+	uint8_t		blocks[CHUNK_HEIGHT][CHUNK_WIDTH * CHUNK_WIDTH]; // Same layout as the chunk layers
+	uint8_t		borders[6][CHUNK_WIDTH * CHUNK_WIDTH]; // Layer of each neighbour touching the chunk
+	uint32_t	occupancy[OCCUPANCY_SIZE]; // Occupancy mask of the chunk, same layout as AChunk::getOccupancy
+	bool		neightbourLoaded[6];
 	ivec3		Wpos;
-	size_t		LOD = 0;
-	bool		neigthbourUpdated = false;
-	bool		inCreation = true;
-} ChunkData;
-typedef unordered_map<ivec3, ChunkData> ChunkMap; // Wpos -> ChunkData ptr
-
-// Interface for chunk & mesh modifications
-enum class ChunkAction {
-	CREATE_UPDATE,
-	DELETE
-};
-typedef pair<ivec3, ChunkAction> ChunkRequest; // Wpos, Action
+	size_t		LOD;
+	uint32_t	version;
+	RequestTicket	ticket; // Of the request being built
+} MeshSnapshot;
 
 // This class is responsible for managing the voxel system 
-// It have 2 child threads: ChunkGeneration & MeshGeneration
+// Chunk generation & mesh generation run as jobs on a shared work-stealing JobSystem
 class VoxelSystem {
+	friend class MeshBenchmark; // benchmarks/MeshBenchmark.hpp, snapshots and meshes chunks without a VoxelSystem
+
 	private:
 		list<ChunkMesh *>	_meshToDelete;
-		ChunkMap	_chunks; // ChunkGeneration output
+		list<ivec3>		_chunksToErase; // Unloaded chunks waiting to be removed from the ChunkMap
+		AChunkMap *	_chunks; // ChunkGeneration output, a GridChunkMap or a HashChunkMap
+		vector<pair<ivec3, ChunkMesh *>>	_drawList; // Meshes collected from the ChunkMap for the current frame
 		Camera &	_camera;
+		ivec3		_cameraChunk; // Chunk the camera was in at the last streaming update
+		ViewState	_viewState; // Camera state the queued requests are prioritized with
 
 		// OpenGL variables
 		GLuint		_textureAtlas;
 		GeoFrameBuffers	_gBuffer;
 
 		// Multi-threading
-		thread *	_chunkGenerationThreads;
-		thread		_meshGenerationThread;
-		bool		_quitting = false;
+		JobSystem *	_jobSystem;
 		uint32_t	_cpuCoreCount;
 
-		deque<ChunkRequest>	_requestedChunks;
-		deque<ChunkRequest>	_requestedMeshes;
+		ChunkRequestQueue	_requestedChunks;
+		ChunkRequestQueue	_requestedMeshes;
 
-		mutex	_requestedChunksMutex;
-		mutex	_requestedMeshesMutex;
-		mutex	_chunksMutex;
 		mutex	_meshToDeleteMutex;
 
+		// Recompaction of the edited chunks, the edits are queued in order by the main thread
+		typedef struct EditedChunk {
+			ivec3				pos;
+			uint32_t			version; // After the edit, a newer edit queues the chunk again
+			chrono::steady_clock::time_point	time;
+		} EditedChunk;
+
+		deque<EditedChunk>	_editedChunks;
+		RecompactionStats	_recompactionStats;
+		mutex			_recompactionMutex; // Guards _recompactionStats
+
 		/// Private functions
 
 		// Initialization functions
@@ -96,17 +112,26 @@ class VoxelSystem {
 		void	_initDefferedRenderingPipeline();
 		void	_loadTextureAtlas();
 
-		// Thread routines
-		void	_chunkGenerationRoutine();
-		void	_meshGenerationRoutine();
+		// Jobs, each one handles a single request
+		void	_chunkGenerationJob();
+		void	_meshGenerationJob();
+		void	_recompactionJob(const vector<EditedChunk> &chunks); // Handles a batch of edited chunks
 
-		void	_generateChunk(ChunkMap::value_type &chunk);
-		void	_deleteChunk  (const ivec3 &pos);
+		bool	_generateChunk(ChunkData &data, AChunk *chunk, const bool &inserted, const RequestTicket &ticket);
+		void	_deleteChunk  (ChunkData &data);
+		void	_scheduleRecompaction();
 
-		void	_generateMesh(ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD);
-		void	_constructChunkMesh(std::vector<DATA_TYPE> *vertices, ChunkData &chunk, ChunkData *neightboursChunks[6], const uint8_t &LOD);
+		bool	_prepareMesh(const ChunkRequest &request, ChunkData *chunk, ChunkData *neightboursChunks[6], MeshSnapshot &snapshot);
+		static void	_takeMeshSnapshot(MeshSnapshot &snapshot, ChunkData &chunk, ChunkData *neightboursChunks[6]);
+		static void	_constructChunkMesh(std::vector<DATA_TYPE> *vertices, const MeshSnapshot &snapshot, const uint8_t &LOD);
+		void	_commitMesh(const MeshSnapshot &snapshot, ChunkMesh *mesh, ChunkData *chunk, ChunkData *neightboursChunks[6]);
 		void	_deleteMesh  (ChunkData &chunk, ChunkData *neightboursChunks[6]);
 
+		// Chunk streaming
+		ivec3	_getCameraChunk();
+		void	_updateRequestPriorities(const bool &force = false);
+		void	_streamChunks();
+
 	public:
 		VoxelSystem(const uint64_t &seed, Camera &camera); // seed 0 = random seed
 		~VoxelSystem();
@@ -116,6 +141,7 @@ class VoxelSystem {
 		void	requestChunk(const vector<ChunkRequest> &requests);
 		void	requestMesh (const vector<ChunkRequest> &requests);
 
+		void	update();
 		void	tryDestroyBlock();
 		const GeoFrameBuffers &	draw(ShaderHandler &shader);
 
@@ -127,4 +153,5 @@ class VoxelSystem {
 
 		size_t	getChunkRequestCount();
 		size_t	getMeshRequestCount();
+		RecompactionStats	getRecompactionStats();
 };
@@ -3,7 +3,12 @@
 bool VERBOSE = false;
 bool SHOW_TOOLTIP = true;
 bool NO_CAVES = false;
+bool GRADIENT_CAVES = false;
+bool FULL_CAVES = false;
 bool POLYGON = false;
+bool GRID_CHUNK_MAP = false;
+bool PACKED_LAYERS = false;
+bool INTERN_LAYERS = false;
 
 static void	printUsage() {
 	cout << BGreen << "=== ft_vox by DailyWind & HaSYxD ===" << ResetColor << endl;
@@ -31,7 +36,12 @@ uint64_t	flagHandler(int argc, char **argv) {
 		else if (arg == "-v" || arg == "--verbose")		VERBOSE = true;
 		else if (arg == "-t" || arg == "--no-tooltip")	SHOW_TOOLTIP = false;
 		else if (arg == "-n" || arg == "--no-caves")	NO_CAVES = true;
+		else if (arg == "-g" || arg == "--gradient-caves")	GRADIENT_CAVES = true;
+		else if (arg == "-f" || arg == "--full-caves")	FULL_CAVES = true;
 		else if (arg == "-p" || arg == "--polygon")	POLYGON = true;
+		else if (arg == "-G" || arg == "--grid-chunks")	GRID_CHUNK_MAP = true;
+		else if (arg == "-P" || arg == "--packed-layers")	PACKED_LAYERS = true;
+		else if (arg == "-I" || arg == "--intern-layers")	INTERN_LAYERS = true;
 
 		else {
 			if (i == argc - 1) {
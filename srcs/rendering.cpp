@@ -31,6 +31,9 @@ static void program_loop(GameData &gameData) {
 	static SkyBox		&skybox      = gameData.skybox;
 	static RenderData	&renderDatas = gameData.renderDatas;
 
+	// Chunk streaming
+	voxelSystem.update();
+
 	// Voxel Geometrie
 	shaders.use(shaders[1]);
 	GeoFrameBuffers	gBuffer = voxelSystem.draw(shaders);